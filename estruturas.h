@@ -0,0 +1,250 @@
+/*
+  estruturas.h
+  Fila dupla circular (deque) e pilha genericas, geradas por macro
+  (somente cabecalho).
+
+  Dois sabores com a mesma interface:
+    DEFINIR_DEQUE_FIXO(Nome, Tipo, CAP)   capacidade fixa em compilacao
+    DEFINIR_DEQUE_DINAMICO(Nome, Tipo)    cresce dobrando (custo amortizado)
+    DEFINIR_PILHA_FIXA(Nome, Tipo, CAP)
+    DEFINIR_PILHA_DINAMICA(Nome, Tipo)
+  e a troca em bloco de k itens entre o inicio de um deque e o topo de
+  uma pilha:
+    DEFINIR_TROCA_DEQUE_PILHA(nomeFuncao, Deque, Pilha, Tipo)
+
+  Cada macro gera um typedef Nome e funcoes Nome_xxx (iniciar, liberar,
+  inserirFim, inserirInicio, removerInicio, removerFim, espiar,
+  segmentos, copiarFaixa, inserirFaixaFim / empilhar, desempilhar, topo,
+  espiar, copiarTopo). O indice circular usa subtracao condicional em vez
+  de modulo; copias de faixa usam no maximo dois memcpy (antes e depois
+  da volta do anel).
+*/
+
+#ifndef ESTRUTURAS_H
+#define ESTRUTURAS_H
+
+#include <stdlib.h>
+#include <string.h>
+
+/* ---------- Deque ---------- */
+
+/* Operacoes comuns; cada sabor fornece Nome_capacidade, Nome_dados e
+   Nome_garantir (garante espaco para n itens, 0 se impossivel). */
+#define DEQUE_OPERACOES_(Nome, Tipo)                                            \
+static inline int Nome##_vazio(const Nome *d) { return d->qtd == 0; }           \
+                                                                                \
+static inline int Nome##_indice(const Nome *d, int i) {                         \
+    int j = d->inicio + i;                                                      \
+    int cap = Nome##_capacidade(d);                                             \
+    return j >= cap ? j - cap : j;                                              \
+}                                                                               \
+                                                                                \
+static inline int Nome##_inserirFim(Nome *d, Tipo x) {                          \
+    if (!Nome##_garantir(d, d->qtd + 1)) return 0;                              \
+    Nome##_dados(d)[Nome##_indice(d, d->qtd)] = x;                              \
+    d->qtd++;                                                                   \
+    return 1;                                                                   \
+}                                                                               \
+                                                                                \
+static inline int Nome##_inserirInicio(Nome *d, Tipo x) {                       \
+    if (!Nome##_garantir(d, d->qtd + 1)) return 0;                              \
+    d->inicio = (d->inicio == 0 ? Nome##_capacidade(d) : d->inicio) - 1;        \
+    Nome##_dados(d)[d->inicio] = x;                                             \
+    d->qtd++;                                                                   \
+    return 1;                                                                   \
+}                                                                               \
+                                                                                \
+static inline int Nome##_removerInicio(Nome *d, Tipo *saida) {                  \
+    if (d->qtd == 0) return 0;                                                  \
+    if (saida) *saida = Nome##_dados(d)[d->inicio];                             \
+    d->inicio = Nome##_indice(d, 1);                                            \
+    d->qtd--;                                                                   \
+    return 1;                                                                   \
+}                                                                               \
+                                                                                \
+static inline int Nome##_removerFim(Nome *d, Tipo *saida) {                     \
+    if (d->qtd == 0) return 0;                                                  \
+    d->qtd--;                                                                   \
+    if (saida) *saida = Nome##_dados(d)[Nome##_indice(d, d->qtd)];              \
+    return 1;                                                                   \
+}                                                                               \
+                                                                                \
+/* Item i a partir do inicio (0 = primeiro), ou NULL */                         \
+static inline Tipo *Nome##_espiar(Nome *d, int i) {                             \
+    if (i < 0 || i >= d->qtd) return NULL;                                      \
+    return &Nome##_dados(d)[Nome##_indice(d, i)];                               \
+}                                                                               \
+                                                                                \
+/* Faixa [i, i+n) como ate dois trechos contiguos a[0..na) e b[0..nb) */        \
+static inline void Nome##_segmentos(Nome *d, int i, int n,                      \
+                                    Tipo **a, int *na, Tipo **b, int *nb) {     \
+    int primeiro = Nome##_indice(d, i);                                         \
+    int ateFim = Nome##_capacidade(d) - primeiro;                               \
+    *a = Nome##_dados(d) + primeiro;                                            \
+    *na = n < ateFim ? n : ateFim;                                              \
+    *b = Nome##_dados(d);                                                       \
+    *nb = n - *na;                                                              \
+}                                                                               \
+                                                                                \
+/* Copia n itens a partir de i para destino (limita ao que existe) */           \
+static inline int Nome##_copiarFaixa(Nome *d, int i, int n, Tipo *destino) {    \
+    Tipo *a, *b;                                                                \
+    int na, nb;                                                                 \
+    if (i < 0 || i > d->qtd) return 0;                                          \
+    if (n > d->qtd - i) n = d->qtd - i;                                         \
+    if (n <= 0) return 0;                                                       \
+    Nome##_segmentos(d, i, n, &a, &na, &b, &nb);                                \
+    memcpy(destino, a, (size_t)na * sizeof(Tipo));                              \
+    if (nb) memcpy(destino + na, b, (size_t)nb * sizeof(Tipo));                 \
+    return n;                                                                   \
+}                                                                               \
+                                                                                \
+static inline int Nome##_inserirFaixaFim(Nome *d, const Tipo *origem, int n) {  \
+    Tipo *a, *b;                                                                \
+    int na, nb;                                                                 \
+    if (n <= 0) return 1;                                                       \
+    if (!Nome##_garantir(d, d->qtd + n)) return 0;                              \
+    Nome##_segmentos(d, d->qtd, n, &a, &na, &b, &nb);                           \
+    memcpy(a, origem, (size_t)na * sizeof(Tipo));                               \
+    if (nb) memcpy(b, origem + na, (size_t)nb * sizeof(Tipo));                  \
+    d->qtd += n;                                                                \
+    return 1;                                                                   \
+}
+
+#define DEFINIR_DEQUE_FIXO(Nome, Tipo, CAP)                                     \
+typedef struct {                                                                \
+    Tipo itens[CAP];                                                            \
+    int inicio, qtd;                                                            \
+} Nome;                                                                         \
+                                                                                \
+static inline void Nome##_iniciar(Nome *d) { d->inicio = 0; d->qtd = 0; }       \
+static inline void Nome##_liberar(Nome *d) { d->inicio = 0; d->qtd = 0; }       \
+static inline int Nome##_capacidade(const Nome *d) { (void)d; return (CAP); }   \
+static inline Tipo *Nome##_dados(Nome *d) { return d->itens; }                  \
+static inline int Nome##_garantir(Nome *d, int n) { (void)d; return n <= (CAP); } \
+DEQUE_OPERACOES_(Nome, Tipo)
+
+#define DEFINIR_DEQUE_DINAMICO(Nome, Tipo)                                      \
+typedef struct {                                                                \
+    Tipo *itens;                                                                \
+    int inicio, qtd, cap;                                                       \
+} Nome;                                                                         \
+                                                                                \
+static inline void Nome##_iniciar(Nome *d) {                                    \
+    d->itens = NULL;                                                            \
+    d->inicio = d->qtd = d->cap = 0;                                            \
+}                                                                               \
+static inline void Nome##_liberar(Nome *d) { free(d->itens); Nome##_iniciar(d); } \
+static inline int Nome##_capacidade(const Nome *d) { return d->cap; }           \
+static inline Tipo *Nome##_dados(Nome *d) { return d->itens; }                  \
+static inline int Nome##_garantir(Nome *d, int n);                              \
+DEQUE_OPERACOES_(Nome, Tipo)                                                    \
+                                                                                \
+/* Dobra a capacidade, desenrolando o anel para o inicio do novo vetor */      \
+static inline int Nome##_garantir(Nome *d, int n) {                             \
+    if (n <= d->cap) return 1;                                                  \
+    int nova = d->cap ? d->cap : 8;                                             \
+    while (nova < n) nova *= 2;                                                 \
+    Tipo *novo = malloc((size_t)nova * sizeof(Tipo));                           \
+    if (!novo) return 0;                                                        \
+    if (d->qtd) Nome##_copiarFaixa(d, 0, d->qtd, novo);                         \
+    free(d->itens);                                                             \
+    d->itens = novo;                                                            \
+    d->inicio = 0;                                                              \
+    d->cap = nova;                                                              \
+    return 1;                                                                   \
+}
+
+/* ---------- Pilha ---------- */
+
+#define PILHA_OPERACOES_(Nome, Tipo)                                            \
+static inline int Nome##_vazia(const Nome *p) { return p->qtd == 0; }           \
+                                                                                \
+static inline int Nome##_empilhar(Nome *p, Tipo x) {                            \
+    if (!Nome##_garantir(p, p->qtd + 1)) return 0;                              \
+    Nome##_dados(p)[p->qtd++] = x;                                              \
+    return 1;                                                                   \
+}                                                                               \
+                                                                                \
+static inline int Nome##_desempilhar(Nome *p, Tipo *saida) {                    \
+    if (p->qtd == 0) return 0;                                                  \
+    p->qtd--;                                                                   \
+    if (saida) *saida = Nome##_dados(p)[p->qtd];                                \
+    return 1;                                                                   \
+}                                                                               \
+                                                                                \
+/* Item i a partir do topo (0 = topo), ou NULL */                               \
+static inline Tipo *Nome##_espiar(Nome *p, int i) {                             \
+    if (i < 0 || i >= p->qtd) return NULL;                                      \
+    return &Nome##_dados(p)[p->qtd - 1 - i];                                    \
+}                                                                               \
+                                                                                \
+static inline Tipo *Nome##_topo(Nome *p) { return Nome##_espiar(p, 0); }        \
+                                                                                \
+/* Copia os n itens do topo (de baixo para cima) com um memcpy */              \
+static inline int Nome##_copiarTopo(Nome *p, int n, Tipo *destino) {            \
+    if (n > p->qtd) n = p->qtd;                                                 \
+    if (n <= 0) return 0;                                                       \
+    memcpy(destino, Nome##_dados(p) + p->qtd - n, (size_t)n * sizeof(Tipo));    \
+    return n;                                                                   \
+}
+
+#define DEFINIR_PILHA_FIXA(Nome, Tipo, CAP)                                     \
+typedef struct {                                                                \
+    Tipo itens[CAP];                                                            \
+    int qtd;                                                                    \
+} Nome;                                                                         \
+                                                                                \
+static inline void Nome##_iniciar(Nome *p) { p->qtd = 0; }                      \
+static inline void Nome##_liberar(Nome *p) { p->qtd = 0; }                      \
+static inline int Nome##_capacidade(const Nome *p) { (void)p; return (CAP); }   \
+static inline Tipo *Nome##_dados(Nome *p) { return p->itens; }                  \
+static inline int Nome##_garantir(Nome *p, int n) { (void)p; return n <= (CAP); } \
+PILHA_OPERACOES_(Nome, Tipo)
+
+#define DEFINIR_PILHA_DINAMICA(Nome, Tipo)                                      \
+typedef struct {                                                                \
+    Tipo *itens;                                                                \
+    int qtd, cap;                                                               \
+} Nome;                                                                         \
+                                                                                \
+static inline void Nome##_iniciar(Nome *p) { p->itens = NULL; p->qtd = p->cap = 0; } \
+static inline void Nome##_liberar(Nome *p) { free(p->itens); Nome##_iniciar(p); } \
+static inline int Nome##_capacidade(const Nome *p) { return p->cap; }           \
+static inline Tipo *Nome##_dados(Nome *p) { return p->itens; }                  \
+static inline int Nome##_garantir(Nome *p, int n) {                             \
+    if (n <= p->cap) return 1;                                                  \
+    int nova = p->cap ? p->cap : 8;                                             \
+    while (nova < n) nova *= 2;                                                 \
+    Tipo *novo = realloc(p->itens, (size_t)nova * sizeof(Tipo));                \
+    if (!novo) return 0;                                                        \
+    p->itens = novo;                                                            \
+    p->cap = nova;                                                              \
+    return 1;                                                                   \
+}                                                                               \
+PILHA_OPERACOES_(Nome, Tipo)
+
+/* ---------- Troca em bloco ---------- */
+
+/* Troca os k primeiros itens do deque com os k do topo da pilha, na
+   ordem da troca multipla do jogo: deque[i] <-> pilha[topo - i].
+   Percorre no maximo dois trechos contiguos do deque contra um trecho
+   contiguo da pilha, sem aritmetica circular por item. */
+#define DEFINIR_TROCA_DEQUE_PILHA(nomeFuncao, Deque, Pilha, Tipo)               \
+static inline int nomeFuncao(Deque *d, Pilha *p, int k) {                       \
+    Tipo *seg[2];                                                               \
+    int n[2];                                                                   \
+    if (k <= 0 || d->qtd < k || p->qtd < k) return 0;                           \
+    Deque##_segmentos(d, 0, k, &seg[0], &n[0], &seg[1], &n[1]);                 \
+    Tipo *t = Pilha##_dados(p) + p->qtd - 1;                                    \
+    for (int s = 0; s < 2; s++) {                                               \
+        for (int i = 0; i < n[s]; i++, t--) {                                   \
+            Tipo aux = seg[s][i];                                               \
+            seg[s][i] = *t;                                                     \
+            *t = aux;                                                           \
+        }                                                                       \
+    }                                                                           \
+    return 1;                                                                   \
+}
+
+#endif /* ESTRUTURAS_H */
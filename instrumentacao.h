@@ -0,0 +1,254 @@
+/*
+  instrumentacao.h
+  Sondas de latencia compartilhadas pelos programas (somente cabecalho).
+
+  Compiladas apenas com -DINSTRUMENTAR; sem a flag as macros viram
+  ((void)0) e nao sobra nenhum codigo nem dado no binario.
+
+  - INSTR_INICIAR()      no main: registra o relatorio na saida (atexit)
+                         e em SIGUSR1 (kill -USR1 <pid>).
+  - INSTR_ESCOPO(nome)   no inicio de um bloco/funcao: mede do ponto da
+                         macro ate a saida do escopo (qualquer return).
+  - INSTR_INICIO(nome) / INSTR_FIM(nome)   mesmo efeito, limites explicitos.
+
+  Cada thread grava em histogramas proprios (sem trava e sem instrucao
+  atomica com lock no caminho da sonda). O histograma e log-linear no
+  estilo HDR: 32 sub-baldes por potencia de 2, erro relativo <= ~3%, de
+  1 ns ate 2^64 ns. O relatorio soma as threads e mostra n, media, p50,
+  p99, p999 e maximo por sonda, em stderr.
+
+  O sinal so marca um pedido; o relatorio sai na proxima sonda executada
+  (printf nao e seguro dentro do tratador). A sonda reivindica o pedido
+  com atomic_exchange, entao so uma thread despeja por sinal, e o despejo
+  roda sob a trava global (nao intercala com o do atexit).
+*/
+
+#ifndef INSTRUMENTACAO_H
+#define INSTRUMENTACAO_H
+
+#ifdef INSTRUMENTAR
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#define INSTR_MAX_SONDAS 32
+#define INSTR_BITS_SUB 5
+#define INSTR_SUB (1 << INSTR_BITS_SUB)
+#define INSTR_BALDES ((64 - INSTR_BITS_SUB + 1) * INSTR_SUB)
+
+typedef struct {
+    _Atomic uint64_t baldes[INSTR_BALDES];
+    _Atomic uint64_t n, soma, max;
+} InstrHistograma;
+
+/* Histogramas de uma thread, encadeados numa lista global so de insercao */
+typedef struct InstrThread {
+    _Atomic(InstrHistograma *) hist[INSTR_MAX_SONDAS];
+    struct InstrThread *prox;
+} InstrThread;
+
+static const char *instrNomes[INSTR_MAX_SONDAS];
+static atomic_int instrNumSondas;
+static atomic_flag instrTrava = ATOMIC_FLAG_INIT;
+static _Atomic(InstrThread *) instrThreads;
+static atomic_int instrPedido;          /* lock-free: seguro no tratador */
+_Static_assert(ATOMIC_INT_LOCK_FREE == 2, "instrPedido precisa ser lock-free");
+static _Thread_local InstrThread *instrLocal;
+
+static inline uint64_t instrAgoraNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Valor -> balde: exato abaixo de 2*SUB; acima, SUB sub-baldes por oitava */
+static inline int instrBalde(uint64_t v) {
+    if (v < 2 * INSTR_SUB) return (int)v;
+    int msb = 63 - __builtin_clzll(v);
+    int desloc = msb - INSTR_BITS_SUB;
+    return (desloc + 1) * INSTR_SUB + (int)((v >> desloc) - INSTR_SUB);
+}
+
+/* Maior valor que cai no balde (o percentil e reportado por cima) */
+static inline uint64_t instrLimiteBalde(int b) {
+    if (b < 2 * INSTR_SUB) return (uint64_t)b;
+    int desloc = b / INSTR_SUB - 1;
+    uint64_t mant = (uint64_t)(INSTR_SUB + b % INSTR_SUB);
+    return ((mant + 1) << desloc) - 1;
+}
+
+static inline void instrTravar(void) {
+    while (atomic_flag_test_and_set_explicit(&instrTrava, memory_order_acquire));
+}
+
+static inline void instrDestravar(void) {
+    atomic_flag_clear_explicit(&instrTrava, memory_order_release);
+}
+
+/* Id da sonda pelo nome (mesmo nome em dois lugares = mesma sonda) */
+static inline int instrRegistrar(const char *nome) {
+    int id = -1;
+    instrTravar();
+    int n = atomic_load(&instrNumSondas);
+    for (int i = 0; i < n; i++)
+        if (strcmp(instrNomes[i], nome) == 0) id = i;
+    if (id < 0 && n < INSTR_MAX_SONDAS) {
+        instrNomes[n] = nome;
+        atomic_store(&instrNumSondas, n + 1);
+        id = n;
+    }
+    instrDestravar();
+    return id;
+}
+
+static inline InstrHistograma *instrHistLocal(int id) {
+    if (!instrLocal) {
+        instrLocal = calloc(1, sizeof(InstrThread));
+        if (!instrLocal) return NULL;
+        instrTravar();
+        instrLocal->prox = atomic_load(&instrThreads);
+        atomic_store(&instrThreads, instrLocal);
+        instrDestravar();
+    }
+    InstrHistograma *h = atomic_load_explicit(&instrLocal->hist[id], memory_order_relaxed);
+    if (!h) {
+        h = calloc(1, sizeof(InstrHistograma));
+        atomic_store_explicit(&instrLocal->hist[id], h, memory_order_release);
+    }
+    return h;
+}
+
+/* So a thread dona escreve: carrega/soma/grava relaxados (sem lock) */
+static inline void instrSomar(_Atomic uint64_t *c, uint64_t v) {
+    atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + v, memory_order_relaxed);
+}
+
+static inline void instrDespejar(void);
+
+static inline void instrRegistrarAmostra(int id, uint64_t ns) {
+    if (id < 0) return;
+    InstrHistograma *h = instrHistLocal(id);
+    if (!h) return;
+    instrSomar(&h->baldes[instrBalde(ns)], 1);
+    instrSomar(&h->n, 1);
+    instrSomar(&h->soma, ns);
+    if (ns > atomic_load_explicit(&h->max, memory_order_relaxed))
+        atomic_store_explicit(&h->max, ns, memory_order_relaxed);
+    if (atomic_load_explicit(&instrPedido, memory_order_relaxed) &&
+        atomic_exchange_explicit(&instrPedido, 0, memory_order_acq_rel))
+        instrDespejar();
+}
+
+/* Limite superior do balde que contem o percentil p (nunca acima do max) */
+static inline uint64_t instrPercentil(const uint64_t *baldes, uint64_t n, double p, uint64_t max) {
+    uint64_t alvo = (uint64_t)(p * (double)n + 0.5), acum = 0;
+    if (alvo < 1) alvo = 1;
+    for (int b = 0; b < INSTR_BALDES; b++) {
+        acum += baldes[b];
+        if (acum >= alvo) return instrLimiteBalde(b) < max ? instrLimiteBalde(b) : max;
+    }
+    return max;
+}
+
+static inline void instrFormatarNs(char *buf, size_t tam, uint64_t ns) {
+    if (ns < 10000) snprintf(buf, tam, "%llu ns", (unsigned long long)ns);
+    else if (ns < 10000000) snprintf(buf, tam, "%.1f us", ns / 1e3);
+    else snprintf(buf, tam, "%.1f ms", ns / 1e6);
+}
+
+/* Soma os histogramas de todas as threads e imprime uma linha por sonda */
+static inline void instrDespejar(void) {
+    uint64_t baldes[INSTR_BALDES];
+    char p50[24], p99[24], p999[24], max[24], media[24];
+    int numSondas = atomic_load(&instrNumSondas);
+    if (!numSondas) return;
+    instrTravar();
+    fprintf(stderr, "\n%-26s %10s %10s %10s %10s %10s %10s\n",
+            "sonda", "n", "media", "p50", "p99", "p999", "max");
+    for (int id = 0; id < numSondas; id++) {
+        uint64_t n = 0, soma = 0, maior = 0;
+        memset(baldes, 0, sizeof(baldes));
+        for (InstrThread *t = atomic_load(&instrThreads); t; t = t->prox) {
+            InstrHistograma *h = atomic_load_explicit(&t->hist[id], memory_order_acquire);
+            if (!h) continue;
+            for (int b = 0; b < INSTR_BALDES; b++)
+                baldes[b] += atomic_load_explicit(&h->baldes[b], memory_order_relaxed);
+            n += atomic_load_explicit(&h->n, memory_order_relaxed);
+            soma += atomic_load_explicit(&h->soma, memory_order_relaxed);
+            uint64_t m = atomic_load_explicit(&h->max, memory_order_relaxed);
+            if (m > maior) maior = m;
+        }
+        if (!n) continue;
+        instrFormatarNs(media, sizeof(media), soma / n);
+        instrFormatarNs(p50, sizeof(p50), instrPercentil(baldes, n, 0.50, maior));
+        instrFormatarNs(p99, sizeof(p99), instrPercentil(baldes, n, 0.99, maior));
+        instrFormatarNs(p999, sizeof(p999), instrPercentil(baldes, n, 0.999, maior));
+        instrFormatarNs(max, sizeof(max), maior);
+        fprintf(stderr, "%-26s %10llu %10s %10s %10s %10s %10s\n", instrNomes[id],
+                (unsigned long long)n, media, p50, p99, p999, max);
+    }
+    instrDestravar();
+}
+
+static inline void instrTratarSinal(int sinal) {
+    (void)sinal;
+    atomic_store_explicit(&instrPedido, 1, memory_order_relaxed);
+}
+
+static inline void instrIniciar(void) {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = instrTratarSinal;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &sa, NULL);
+    atexit(instrDespejar);
+}
+
+typedef struct {
+    int id;
+    uint64_t inicio;
+} InstrEscopo;
+
+static inline InstrEscopo instrAbrir(atomic_int *id, const char *nome) {
+    InstrEscopo e;
+    e.id = atomic_load_explicit(id, memory_order_relaxed);
+    if (e.id == -2) {
+        e.id = instrRegistrar(nome);
+        atomic_store_explicit(id, e.id, memory_order_relaxed);
+    }
+    e.inicio = instrAgoraNs();
+    return e;
+}
+
+static inline void instrFechar(InstrEscopo *e) {
+    instrRegistrarAmostra(e->id, instrAgoraNs() - e->inicio);
+}
+
+/* -2 = ainda nao registrada; -1 = sem espaco (sonda ignorada) */
+#define INSTR_ID_(nome) static atomic_int instrId_##nome = -2
+
+#define INSTR_INICIAR() instrIniciar()
+#define INSTR_ESCOPO(nome) \
+    INSTR_ID_(nome); \
+    InstrEscopo instrEscopo_##nome __attribute__((cleanup(instrFechar))) = instrAbrir(&instrId_##nome, #nome)
+#define INSTR_INICIO(nome) \
+    INSTR_ID_(nome); \
+    InstrEscopo instrEscopo_##nome = instrAbrir(&instrId_##nome, #nome)
+#define INSTR_FIM(nome) instrFechar(&instrEscopo_##nome)
+
+#else
+
+#define INSTR_INICIAR() ((void)0)
+#define INSTR_ESCOPO(nome) ((void)0)
+#define INSTR_INICIO(nome) ((void)0)
+#define INSTR_FIM(nome) ((void)0)
+
+#endif /* INSTRUMENTAR */
+
+#endif /* INSTRUMENTACAO_H */
@@ -4,12 +4,20 @@
 
   Compilar:
     gcc -std=c11 -Wall -Wextra -o torre torre.c
+  Com --saida-direta as tabelas saem com um write por linha (como o printf
+  original) em vez de um write por tabela; bytes, writes e tempo por tabela
+  de cada modo saem em stderr ao terminar.
+  Com -DINSTRUMENTAR, imprime latencias (p50/p99/p999) das ordenacoes e da
+  busca ao sair ou em SIGUSR1 (ver instrumentacao.h).
 */
 
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include "render.h"
+#include "instrumentacao.h"
 
 #define MAX_COMPONENTES 20
 #define MAX_NOME 30
@@ -21,6 +29,9 @@ typedef struct {
     int prioridade;   // 1..10
 } Componente;
 
+static int saidaDireta = 0;
+static MedidaSaida medidaTabelas;
+
 /* ---------- Prototypes ---------- */
 
 /* Leitura segura de string (fgets + trim newline) */
@@ -58,22 +69,27 @@ void lerString(char *buf, int tam) {
     buf[strcspn(buf, "\n")] = '\0'; // remove newline
 }
 
+/* Monta a tabela em um buffer reutilizado e envia com um único write
+   (um por linha com --saida-direta) */
 void mostrarComponentes(const Componente arr[], int n) {
+    static BufferSaida saida;
     if (n <= 0) {
         printf("(Nenhum componente cadastrado)\n");
         return;
     }
-    printf("\nLista de componentes (total %d):\n", n);
-    printf("Idx  Nome                          Tipo               Prioridade\n");
-    printf("-----------------------------------------------------------------\n");
+    bufPrintf(&saida, "\nLista de componentes (total %d):\n", n);
+    bufPrintf(&saida, "Idx  Nome                          Tipo               Prioridade\n");
+    bufPrintf(&saida, "-----------------------------------------------------------------\n");
     for (int i = 0; i < n; ++i) {
-        printf("%2d   %-28s %-18s %2d\n", i, arr[i].nome, arr[i].tipo, arr[i].prioridade);
+        bufPrintf(&saida, "%2d   %-28s %-18s %2d\n", i, arr[i].nome, arr[i].tipo, arr[i].prioridade);
     }
-    printf("\n");
+    bufPrintf(&saida, "\n");
+    bufEnviarMedido(&saida, saidaDireta, &medidaTabelas);
 }
 
 /* --- Bubble sort por nome (strings). Conta comparações de strcmp. --- */
 void bubbleSortNome(Componente arr[], int n, long *comparacoes) {
+    INSTR_ESCOPO(bubbleSortNome);
     if (comparacoes) *comparacoes = 0;
     for (int i = 0; i < n - 1; ++i) {
         int trocou = 0;
@@ -92,6 +108,7 @@ void bubbleSortNome(Componente arr[], int n, long *comparacoes) {
 
 /* --- Insertion sort por tipo (strings). Conta comparações de strcmp. --- */
 void insertionSortTipo(Componente arr[], int n, long *comparacoes) {
+    INSTR_ESCOPO(insertionSortTipo);
     if (comparacoes) *comparacoes = 0;
     for (int i = 1; i < n; ++i) {
         Componente chave = arr[i];
@@ -110,6 +127,7 @@ void insertionSortTipo(Componente arr[], int n, long *comparacoes) {
 
 /* --- Selection sort por prioridade (int). Conta comparações de inteiro. --- */
 void selectionSortPrioridade(Componente arr[], int n, long *comparacoes) {
+    INSTR_ESCOPO(selectionSortPrioridade);
     if (comparacoes) *comparacoes = 0;
     for (int i = 0; i < n - 1; ++i) {
         int idxMin = i;
@@ -128,6 +146,7 @@ void selectionSortPrioridade(Componente arr[], int n, long *comparacoes) {
 /* --- Busca binária por nome.
        Conta comparações: cada strcmp com o elemento do meio conta 1. --- */
 int buscaBinariaPorNome(const Componente arr[], int n, const char chave[], long *comparacoes) {
+    INSTR_ESCOPO(buscaBinariaPorNome);
     int low = 0, high = n - 1;
     if (comparacoes) *comparacoes = 0;
     while (low <= high) {
@@ -160,7 +179,10 @@ void limparBufferStdin(void) {
 }
 
 /* ---------- Função main: interface e fluxo ---------- */
-int main(void) {
+int main(int argc, char *argv[]) {
+    INSTR_INICIAR();
+    for (int i = 1; i < argc; ++i)
+        if (strcmp(argv[i], "--saida-direta") == 0) saidaDireta = 1;
     Componente orig[MAX_COMPONENTES];   // vetor original (como o jogador cadastrou)
     Componente trabalho[MAX_COMPONENTES]; // vetor de trabalho onde se aplicam ordenações
     int n = 0; // quantidade cadastrada
@@ -354,5 +376,6 @@ int main(void) {
 
     } while (op != 0);
 
+    medidaEstatisticas(&medidaTabelas, saidaDireta ? "direta" : "buffer", stderr);
     return 0;
 }
@@ -1,43 +1,1593 @@
+/*
+  logicaSuperTrunfo.c
+  Desafio Super Trunfo - Paises. Tema 2 - Comparacao das Cartas.
+
+  As cartas ficam em um Baralho organizado por colunas: um vetor contiguo
+  por atributo (populacao, area, PIB, pontos turisticos, densidade, PIB per
+  capita e super poder). Assim uma carta pode ser comparada com o baralho
+  inteiro atributo a atributo por kernels SIMD, que devolvem mascaras de
+  bits com as cartas vencidas (bit j = a carta vence a carta j).
+  Regra: maior valor vence, exceto densidade populacional (menor vence).
+
+  Os valores sao ponto fixo de 64 bits (Fixo, em milionesimos): entrada
+  decimal convertida sem passar por double e atributos derivados calculados
+  em aritmetica inteira de 128 bits com arredondamento definido (metade
+  para longe do zero). As comparacoes sao inteiras e, portanto, identicas
+  bit a bit em qualquer compilador, ordem de avaliacao ou uso de FMA.
+
+  Compilar:
+    gcc -std=c11 -Wall -Wextra -O2 -pthread -o logicaSuperTrunfo logicaSuperTrunfo.c
+
+  Uso:
+    ./logicaSuperTrunfo            cadastro e comparacao de duas cartas
+    ./logicaSuperTrunfo --bench N  mede comparacoes/ms em um baralho de N cartas
+                                   (ponto fixo x a versao em double)
+    ./logicaSuperTrunfo --torneio N [--regra p1,...,p7] [--saida arq.csv] [--threads T]
+        todos contra todos: vitorias exatas por atributo via ordenacao
+        (O(N log N)); com --regra, tambem todos os pares em blocos, em
+        paralelo, com a regra "soma ponderada das comparacoes > 0"
+        (pesos decimais em ponto fixo, na ordem dos atributos; soma zero
+        e empate; 1,1,1,1,1,1,1 = maioria); com --regra, o CSV de --saida
+        e gravado por bloco, a medida que os blocos terminam
+    ./logicaSuperTrunfo --gerar-csv N cidades.csv   gera N cidades aleatorias
+    ./logicaSuperTrunfo --converter cidades.csv cartas.bin
+        le o CSV (estado,codigo,nome,populacao,area,pib,pontos), calcula os
+        atributos derivados uma vez e grava o formato binario por colunas
+    ./logicaSuperTrunfo --baralho cartas.bin [--torneio] ...
+        carrega o baralho (binario via mmap, sem parsing; CSV e aceito para
+        comparacao) e, com --torneio, usa-o no lugar do baralho gerado
+    ./logicaSuperTrunfo --ranking N [--baralho arq] [--consultas Q] [--threads T]
+        constroi os indices ordenados por atributo e compara consultas
+        "quantas cartas X vence" e "top 10" com a varredura linear
+
+  Com -DINSTRUMENTAR, latencias (p50/p99/p999) das comparacoes, dos
+  blocos do torneio e das consultas ao indice saem em stderr ao terminar
+  ou com kill -USR1 (ver instrumentacao.h).
+*/
+
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <ctype.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "instrumentacao.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TEM_X86 1
+#endif
+
+#define MAX_NOME 50
+#define ALINHAMENTO 64
+#define BITS_MASCARA 64
+#define BLOCO_I 64          /* linhas por tarefa no todos-contra-todos */
+#define BLOCO_J 2048        /* colunas por ladrilho (cabe na cache L2) */
+#define LIMITE_CONFERENCIA 20000
+
+/* Ponto fixo: valor real = Fixo / ESCALA_FIXO. Cabe ate ~9,2e12 por campo. */
+typedef int64_t Fixo;
+__extension__ typedef __int128 Fixo128;
+#define ESCALA_FIXO 1000000
+#define CASAS_FIXO 6
+#define TAM_TEXTO_FIXO (1 + 20 + 1 + CASAS_FIXO + 1)   /* sinal, inteiro, '.', casas, NUL */
+
+typedef enum {
+    ATR_POPULACAO,
+    ATR_AREA,
+    ATR_PIB,
+    ATR_PONTOS,
+    ATR_DENSIDADE,
+    ATR_PIB_PER_CAPITA,
+    ATR_SUPER_PODER,
+    NUM_ATRIBUTOS
+} Atributo;
+
+static const char *nomesAtributos[NUM_ATRIBUTOS] = {
+    "Populacao", "Area", "PIB", "Pontos turisticos",
+    "Densidade populacional", "PIB per capita", "Super poder"
+};
+
+/* Carta como o jogador cadastra (uma linha) */
+typedef struct {
+    char estado;
+    char codigo[4];
+    char nome[MAX_NOME];
+    unsigned long populacao;
+    Fixo area;              /* km2 */
+    Fixo pib;               /* bilhoes de reais */
+    int pontosTuristicos;
+} Carta;
+
+/* Baralho por colunas. Os atributos derivados sao calculados uma vez ao
+   adicionar a carta. Colunas alinhadas a 64 bytes para os kernels.
+   Se mapa != NULL as colunas apontam para um arquivo mapeado (somente
+   leitura): o baralho nao cresce e liberar desfaz o mapeamento. */
+typedef struct {
+    size_t n, cap;
+    Fixo *col[NUM_ATRIBUTOS];
+    char *estado;
+    char (*codigo)[4];
+    char (*nome)[MAX_NOME];
+    void *mapa;
+    size_t tamMapa;
+} Baralho;
+
+/* ---------- Ponto fixo ---------- */
+
+static Fixo saturarFixo(Fixo128 x) {
+    if (x > INT64_MAX) return INT64_MAX;
+    if (x < INT64_MIN) return INT64_MIN;
+    return (Fixo)x;
+}
+
+/* num / den arredondado para o mais proximo, metade para longe do zero */
+static Fixo128 dividirArredondado(Fixo128 num, Fixo128 den) {
+    if (den < 0) { num = -num; den = -den; }
+    return num >= 0 ? (num + den / 2) / den : -((-num + den / 2) / den);
+}
+
+/* Converte texto decimal ("1234.5678", "-0.5") direto para Fixo, sem
+   double: digitos alem de CASAS_FIXO arredondam metade para longe do
+   zero. Devolve o fim do numero em *fim (== texto se nao houver digito). */
+Fixo textoParaFixo(const char *texto, char **fim) {
+    const char *p = texto;
+    int negativo = 0, digitos = 0, casas = 0, arredonda = 0;
+    Fixo128 inteiro = 0;
+    while (isspace((unsigned char)*p)) p++;
+    if (*p == '+' || *p == '-') negativo = *p++ == '-';
+    for (; isdigit((unsigned char)*p); p++, digitos++)
+        if (inteiro <= INT64_MAX) inteiro = inteiro * 10 + (*p - '0');
+    if (*p == '.') {
+        for (p++; isdigit((unsigned char)*p); p++, digitos++) {
+            if (casas < CASAS_FIXO) { inteiro = inteiro * 10 + (*p - '0'); casas++; }
+            else if (casas++ == CASAS_FIXO) arredonda = *p >= '5';
+        }
+    }
+    if (!digitos) { if (fim) *fim = (char *)texto; return 0; }
+    for (; casas < CASAS_FIXO; casas++) inteiro *= 10;
+    inteiro += arredonda;
+    if (fim) *fim = (char *)p;
+    return saturarFixo(negativo ? -inteiro : inteiro);
+}
+
+/* Escreve v com 'casas' decimais (0..CASAS_FIXO), arredondando como acima.
+   buf com TAM_TEXTO_FIXO bytes sempre comporta o resultado. */
+char *formatarFixo(char *buf, size_t tam, Fixo v, int casas) {
+    Fixo128 div = 1;
+    if (casas < 0) casas = 0;
+    if (casas > CASAS_FIXO) casas = CASAS_FIXO;
+    for (int i = casas; i < CASAS_FIXO; i++) div *= 10;
+    Fixo128 x = dividirArredondado(v, div);
+    Fixo128 escala = ESCALA_FIXO / div;
+    Fixo128 absx = x < 0 ? -x : x;
+    unsigned long long inteira = (unsigned long long)(absx / escala);
+    unsigned long long frac = (unsigned long long)(absx % escala);
+    int n = casas > 0 ? snprintf(buf, tam, "%s%llu.%0*llu", x < 0 ? "-" : "", inteira, casas, frac)
+                      : snprintf(buf, tam, "%s%llu", x < 0 ? "-" : "", inteira);
+    if (n < 0 || (size_t)n >= tam) buf[0] = '\0';   /* buffer curto: nada pela metade */
+    return buf;
+}
+
+/* ---------- Baralho ---------- */
+
+void iniciarBaralho(Baralho *b) {
+    memset(b, 0, sizeof(*b));
+}
+
+void liberarBaralho(Baralho *b) {
+    if (b->mapa) {
+        munmap(b->mapa, b->tamMapa);
+        iniciarBaralho(b);
+        return;
+    }
+    for (int a = 0; a < NUM_ATRIBUTOS; a++) free(b->col[a]);
+    free(b->estado);
+    free(b->codigo);
+    free(b->nome);
+    iniciarBaralho(b);
+}
+
+/* aligned_alloc exige tamanho multiplo do alinhamento */
+static void *alocarAlinhado(size_t bytes) {
+    bytes = (bytes + ALINHAMENTO - 1) / ALINHAMENTO * ALINHAMENTO;
+    return aligned_alloc(ALINHAMENTO, bytes ? bytes : ALINHAMENTO);
+}
+
+int reservarBaralho(Baralho *b, size_t cap) {
+    if (cap <= b->cap) return 1;
+    if (b->mapa) return 0;
+    size_t nova = b->cap ? b->cap : 64;
+    while (nova < cap) nova *= 2;
+    for (int a = 0; a < NUM_ATRIBUTOS; a++) {
+        Fixo *col = alocarAlinhado(nova * sizeof(Fixo));
+        if (!col) return 0;
+        if (b->n) memcpy(col, b->col[a], b->n * sizeof(Fixo));
+        free(b->col[a]);
+        b->col[a] = col;
+    }
+    char *estado = realloc(b->estado, nova);
+    if (!estado) return 0;
+    b->estado = estado;
+    char (*codigo)[4] = realloc(b->codigo, nova * sizeof(*codigo));
+    if (!codigo) return 0;
+    b->codigo = codigo;
+    char (*nome)[MAX_NOME] = realloc(b->nome, nova * sizeof(*nome));
+    if (!nome) return 0;
+    b->nome = nome;
+    b->cap = nova;
+    return 1;
+}
+
+/* Calcula os atributos derivados de uma carta em ponto fixo. Cada
+   derivado e uma unica divisao inteira arredondada; o super poder e uma
+   soma inteira (exata, independe da ordem). */
+void calcularAtributos(const Carta *c, Fixo valores[NUM_ATRIBUTOS]) {
+    Fixo128 pop = (Fixo128)c->populacao;
+    valores[ATR_POPULACAO] = saturarFixo(pop * ESCALA_FIXO);
+    valores[ATR_AREA] = c->area;
+    valores[ATR_PIB] = c->pib;
+    valores[ATR_PONTOS] = saturarFixo((Fixo128)c->pontosTuristicos * ESCALA_FIXO);
+    /* densidade = pop / area  ->  pop * E * E / areaFixo */
+    valores[ATR_DENSIDADE] = c->area > 0
+        ? saturarFixo(dividirArredondado(pop * ESCALA_FIXO * ESCALA_FIXO, c->area)) : 0;
+    /* PIB per capita = pib * 1e9 / pop (reais)  ->  pibFixo * 1e9 / pop */
+    valores[ATR_PIB_PER_CAPITA] = pop > 0
+        ? saturarFixo(dividirArredondado((Fixo128)c->pib * 1000000000, pop)) : 0;
+    /* inverso da densidade = area / pop  ->  areaFixo / pop */
+    Fixo128 inverso = pop > 0 && c->area > 0 ? dividirArredondado(c->area, pop) : 0;
+    /* super poder: soma dos atributos + inverso da densidade */
+    valores[ATR_SUPER_PODER] = saturarFixo((Fixo128)valores[ATR_POPULACAO] + valores[ATR_AREA]
+                                          + valores[ATR_PIB] + valores[ATR_PONTOS]
+                                          + valores[ATR_PIB_PER_CAPITA] + inverso);
+}
+
+/* Mesmos atributos em double, como eram antes (so para o benchmark) */
+void calcularAtributosFlutuante(const Carta *c, double valores[NUM_ATRIBUTOS]) {
+    double pop = (double)c->populacao;
+    double area = (double)c->area / ESCALA_FIXO, pib = (double)c->pib / ESCALA_FIXO;
+    valores[ATR_POPULACAO] = pop;
+    valores[ATR_AREA] = area;
+    valores[ATR_PIB] = pib;
+    valores[ATR_PONTOS] = c->pontosTuristicos;
+    valores[ATR_DENSIDADE] = area > 0 ? pop / area : 0.0;
+    valores[ATR_PIB_PER_CAPITA] = pop > 0 ? pib * 1e9 / pop : 0.0;
+    valores[ATR_SUPER_PODER] = pop + area + pib + c->pontosTuristicos
+                             + valores[ATR_PIB_PER_CAPITA]
+                             + (valores[ATR_DENSIDADE] > 0 ? 1.0 / valores[ATR_DENSIDADE] : 0.0);
+}
+
+int adicionarCarta(Baralho *b, const Carta *c) {
+    Fixo valores[NUM_ATRIBUTOS];
+    if (!reservarBaralho(b, b->n + 1)) return 0;
+    calcularAtributos(c, valores);
+    for (int a = 0; a < NUM_ATRIBUTOS; a++) b->col[a][b->n] = valores[a];
+    b->estado[b->n] = c->estado;
+    memcpy(b->codigo[b->n], c->codigo, sizeof(b->codigo[0]));
+    memcpy(b->nome[b->n], c->nome, sizeof(b->nome[0]));
+    b->n++;
+    return 1;
+}
+
+static inline size_t palavrasMascara(size_t n) {
+    return (n + BITS_MASCARA - 1) / BITS_MASCARA;
+}
+
+/* ---------- Kernels de comparacao ---------- */
+
+/* maior = 1: bit j quando v > col[j]; maior = 0: bit j quando v < col[j].
+   Escalar (referencia e restos). */
+static void kernelEscalar(const Fixo *col, size_t n, Fixo v, int maior, uint64_t *mascara) {
+    for (size_t w = 0; w < palavrasMascara(n); w++) {
+        uint64_t bits = 0;
+        size_t fim = (w + 1) * BITS_MASCARA < n ? (w + 1) * BITS_MASCARA : n;
+        for (size_t j = w * BITS_MASCARA; j < fim; j++) {
+            int vence = maior ? v > col[j] : v < col[j];
+            bits |= (uint64_t)vence << (j % BITS_MASCARA);
+        }
+        mascara[w] = bits;
+    }
+}
+
+static void kernelParEscalar(const Fixo *a, const Fixo *b, size_t n, int maior, uint64_t *mascara) {
+    for (size_t w = 0; w < palavrasMascara(n); w++) {
+        uint64_t bits = 0;
+        size_t fim = (w + 1) * BITS_MASCARA < n ? (w + 1) * BITS_MASCARA : n;
+        for (size_t j = w * BITS_MASCARA; j < fim; j++) {
+            int vence = maior ? a[j] > b[j] : a[j] < b[j];
+            bits |= (uint64_t)vence << (j % BITS_MASCARA);
+        }
+        mascara[w] = bits;
+    }
+}
+
+/* Placar ponderado do torneio: pontos[j] += w se v > col[j], -w se v < col[j]
+   (inteiro: empate exato da soma continua empate) */
+static void kernelPontosEscalar(const Fixo *col, size_t n, Fixo v, Fixo w, int64_t *pontos) {
+    for (size_t j = 0; j < n; j++)
+        pontos[j] += w * ((v > col[j]) - (v < col[j]));
+}
+
+/* Versao em ponto flutuante, mantida so para o benchmark comparativo */
+static void kernelFlutuanteEscalar(const double *col, size_t n, double v, int maior, uint64_t *mascara) {
+    for (size_t w = 0; w < palavrasMascara(n); w++) {
+        uint64_t bits = 0;
+        size_t fim = (w + 1) * BITS_MASCARA < n ? (w + 1) * BITS_MASCARA : n;
+        for (size_t j = w * BITS_MASCARA; j < fim; j++) {
+            int vence = maior ? v > col[j] : v < col[j];
+            bits |= (uint64_t)vence << (j % BITS_MASCARA);
+        }
+        mascara[w] = bits;
+    }
+}
+
+#ifdef TEM_X86
+/* AVX2: 4 inteiros de 64 bits por comparacao (vpcmpgtq), 16 comparacoes
+   por palavra de mascara. Compilado com atributo target e escolhido em
+   tempo de execucao. O sentido da comparacao e constante em cada
+   instancia inlined; "menor" e o mesmo cmpgt com operandos trocados. */
+__attribute__((target("avx2"), always_inline))
+static inline int movemaskAvx2(__m256i cmp) {
+    return _mm256_movemask_pd(_mm256_castsi256_pd(cmp));
+}
+
+__attribute__((target("avx2"), always_inline))
+static inline void kernelAvx2Sentido(const Fixo *col, size_t n, Fixo v, const int maior, uint64_t *mascara) {
+    __m256i vv = _mm256_set1_epi64x(v);
+    size_t cheias = n / BITS_MASCARA;
+    for (size_t w = 0; w < cheias; w++) {
+        const Fixo *p = col + w * BITS_MASCARA;
+        uint64_t bits = 0;
+        for (int k = 0; k < BITS_MASCARA; k += 4) {
+            __m256i x = _mm256_load_si256((const __m256i *)(p + k));
+            __m256i cmp = maior ? _mm256_cmpgt_epi64(vv, x) : _mm256_cmpgt_epi64(x, vv);
+            bits |= (uint64_t)movemaskAvx2(cmp) << k;
+        }
+        mascara[w] = bits;
+    }
+    if (n % BITS_MASCARA)
+        kernelEscalar(col + cheias * BITS_MASCARA, n % BITS_MASCARA, v, maior, mascara + cheias);
+}
+
+__attribute__((target("avx2")))
+static void kernelAvx2(const Fixo *col, size_t n, Fixo v, int maior, uint64_t *mascara) {
+    if (maior) kernelAvx2Sentido(col, n, v, 1, mascara);
+    else kernelAvx2Sentido(col, n, v, 0, mascara);
+}
+
+__attribute__((target("avx2"), always_inline))
+static inline void kernelParAvx2Sentido(const Fixo *a, const Fixo *b, size_t n, const int maior, uint64_t *mascara) {
+    size_t cheias = n / BITS_MASCARA;
+    for (size_t w = 0; w < cheias; w++) {
+        const Fixo *pa = a + w * BITS_MASCARA, *pb = b + w * BITS_MASCARA;
+        uint64_t bits = 0;
+        for (int k = 0; k < BITS_MASCARA; k += 4) {
+            __m256i x = _mm256_load_si256((const __m256i *)(pa + k));
+            __m256i y = _mm256_load_si256((const __m256i *)(pb + k));
+            __m256i cmp = maior ? _mm256_cmpgt_epi64(x, y) : _mm256_cmpgt_epi64(y, x);
+            bits |= (uint64_t)movemaskAvx2(cmp) << k;
+        }
+        mascara[w] = bits;
+    }
+    if (n % BITS_MASCARA)
+        kernelParEscalar(a + cheias * BITS_MASCARA, b + cheias * BITS_MASCARA,
+                         n % BITS_MASCARA, maior, mascara + cheias);
+}
+
+__attribute__((target("avx2")))
+static void kernelParAvx2(const Fixo *a, const Fixo *b, size_t n, int maior, uint64_t *mascara) {
+    if (maior) kernelParAvx2Sentido(a, b, n, 1, mascara);
+    else kernelParAvx2Sentido(a, b, n, 0, mascara);
+}
+
+__attribute__((target("avx2")))
+static void kernelPontosAvx2(const Fixo *col, size_t n, Fixo v, Fixo w, int64_t *pontos) {
+    __m256i vv = _mm256_set1_epi64x(v);
+    __m256i ww = _mm256_set1_epi64x(w);
+    size_t j = 0;
+    for (; j + 4 <= n; j += 4) {
+        __m256i x = _mm256_load_si256((const __m256i *)(col + j));
+        __m256i ganho = _mm256_and_si256(_mm256_cmpgt_epi64(vv, x), ww);
+        __m256i perda = _mm256_and_si256(_mm256_cmpgt_epi64(x, vv), ww);
+        __m256i *p = (__m256i *)(pontos + j);
+        _mm256_store_si256(p, _mm256_add_epi64(_mm256_load_si256(p), _mm256_sub_epi64(ganho, perda)));
+    }
+    kernelPontosEscalar(col + j, n - j, v, w, pontos + j);
+}
+
+/* Referencia em ponto flutuante para o benchmark (4 doubles por vez) */
+__attribute__((target("avx2")))
+static void kernelFlutuanteAvx2(const double *col, size_t n, double v, int maior, uint64_t *mascara) {
+    __m256d vv = _mm256_set1_pd(v);
+    size_t cheias = n / BITS_MASCARA;
+    for (size_t w = 0; w < cheias; w++) {
+        const double *p = col + w * BITS_MASCARA;
+        uint64_t bits = 0;
+        for (int k = 0; k < BITS_MASCARA; k += 4) {
+            __m256d x = _mm256_load_pd(p + k);
+            __m256d cmp = maior ? _mm256_cmp_pd(vv, x, _CMP_GT_OQ) : _mm256_cmp_pd(vv, x, _CMP_LT_OQ);
+            bits |= (uint64_t)_mm256_movemask_pd(cmp) << k;
+        }
+        mascara[w] = bits;
+    }
+    if (n % BITS_MASCARA)
+        kernelFlutuanteEscalar(col + cheias * BITS_MASCARA, n % BITS_MASCARA, v, maior, mascara + cheias);
+}
+
+/* SSE4.2: 2 inteiros de 64 bits por comparacao (pcmpgtq nao existe no
+   SSE2 base; sem SSE4.2 fica o escalar) */
+__attribute__((target("sse4.2"), always_inline))
+static inline void kernelSse42Sentido(const Fixo *col, size_t n, Fixo v, const int maior, uint64_t *mascara) {
+    __m128i vv = _mm_set1_epi64x(v);
+    size_t cheias = n / BITS_MASCARA;
+    for (size_t w = 0; w < cheias; w++) {
+        const Fixo *p = col + w * BITS_MASCARA;
+        uint64_t bits = 0;
+        for (int k = 0; k < BITS_MASCARA; k += 2) {
+            __m128i x = _mm_load_si128((const __m128i *)(p + k));
+            __m128i cmp = maior ? _mm_cmpgt_epi64(vv, x) : _mm_cmpgt_epi64(x, vv);
+            bits |= (uint64_t)_mm_movemask_pd(_mm_castsi128_pd(cmp)) << k;
+        }
+        mascara[w] = bits;
+    }
+    if (n % BITS_MASCARA)
+        kernelEscalar(col + cheias * BITS_MASCARA, n % BITS_MASCARA, v, maior, mascara + cheias);
+}
+
+__attribute__((target("sse4.2")))
+static void kernelSse42(const Fixo *col, size_t n, Fixo v, int maior, uint64_t *mascara) {
+    if (maior) kernelSse42Sentido(col, n, v, 1, mascara);
+    else kernelSse42Sentido(col, n, v, 0, mascara);
+}
+
+__attribute__((target("sse4.2"), always_inline))
+static inline void kernelParSse42Sentido(const Fixo *a, const Fixo *b, size_t n, const int maior, uint64_t *mascara) {
+    size_t cheias = n / BITS_MASCARA;
+    for (size_t w = 0; w < cheias; w++) {
+        const Fixo *pa = a + w * BITS_MASCARA, *pb = b + w * BITS_MASCARA;
+        uint64_t bits = 0;
+        for (int k = 0; k < BITS_MASCARA; k += 2) {
+            __m128i x = _mm_load_si128((const __m128i *)(pa + k));
+            __m128i y = _mm_load_si128((const __m128i *)(pb + k));
+            __m128i cmp = maior ? _mm_cmpgt_epi64(x, y) : _mm_cmpgt_epi64(y, x);
+            bits |= (uint64_t)_mm_movemask_pd(_mm_castsi128_pd(cmp)) << k;
+        }
+        mascara[w] = bits;
+    }
+    if (n % BITS_MASCARA)
+        kernelParEscalar(a + cheias * BITS_MASCARA, b + cheias * BITS_MASCARA,
+                         n % BITS_MASCARA, maior, mascara + cheias);
+}
+
+__attribute__((target("sse4.2")))
+static void kernelParSse42(const Fixo *a, const Fixo *b, size_t n, int maior, uint64_t *mascara) {
+    if (maior) kernelParSse42Sentido(a, b, n, 1, mascara);
+    else kernelParSse42Sentido(a, b, n, 0, mascara);
+}
+
+__attribute__((target("sse4.2")))
+static void kernelPontosSse42(const Fixo *col, size_t n, Fixo v, Fixo w, int64_t *pontos) {
+    __m128i vv = _mm_set1_epi64x(v);
+    __m128i ww = _mm_set1_epi64x(w);
+    size_t j = 0;
+    for (; j + 2 <= n; j += 2) {
+        __m128i x = _mm_load_si128((const __m128i *)(col + j));
+        __m128i ganho = _mm_and_si128(_mm_cmpgt_epi64(vv, x), ww);
+        __m128i perda = _mm_and_si128(_mm_cmpgt_epi64(x, vv), ww);
+        __m128i *p = (__m128i *)(pontos + j);
+        _mm_store_si128(p, _mm_add_epi64(_mm_load_si128(p), _mm_sub_epi64(ganho, perda)));
+    }
+    kernelPontosEscalar(col + j, n - j, v, w, pontos + j);
+}
+#endif
+
+typedef void (*KernelCarta)(const Fixo *, size_t, Fixo, int, uint64_t *);
+typedef void (*KernelPar)(const Fixo *, const Fixo *, size_t, int, uint64_t *);
+typedef void (*KernelPontos)(const Fixo *, size_t, Fixo, Fixo, int64_t *);
+typedef void (*KernelFlutuante)(const double *, size_t, double, int, uint64_t *);
+
+static KernelCarta kernelCarta = kernelEscalar;
+static KernelPar kernelPar = kernelParEscalar;
+static KernelPontos kernelPontos = kernelPontosEscalar;
+static KernelFlutuante kernelFlutuante = kernelFlutuanteEscalar;
+static const char *nomeKernel = "escalar";
+
+/* Escolhe o melhor kernel suportado pela CPU */
+void selecionarKernels(void) {
+#ifdef TEM_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        kernelCarta = kernelAvx2;
+        kernelPar = kernelParAvx2;
+        kernelPontos = kernelPontosAvx2;
+        kernelFlutuante = kernelFlutuanteAvx2;
+        nomeKernel = "avx2";
+    } else if (__builtin_cpu_supports("sse4.2")) {
+        kernelCarta = kernelSse42;
+        kernelPar = kernelParSse42;
+        kernelPontos = kernelPontosSse42;
+        nomeKernel = "sse4.2";
+    }
+#endif
+}
+
+/* Menor valor vence apenas na densidade */
+static inline int maiorVence(int atributo) {
+    return atributo != ATR_DENSIDADE;
+}
+
+/* Compara a carta idx contra todo o baralho. mascaras[a] precisa de
+   palavrasMascara(b->n) palavras; bit j = carta idx vence a carta j. */
+void compararCartaBaralho(const Baralho *b, size_t idx, uint64_t *mascaras[NUM_ATRIBUTOS]) {
+    INSTR_ESCOPO(compararCartaBaralho);
+    for (int a = 0; a < NUM_ATRIBUTOS; a++)
+        kernelCarta(b->col[a], b->n, b->col[a][idx], maiorVence(a), mascaras[a]);
+}
+
+/* Compara as cartas de mesma posicao de dois baralhos (rodadas em
+   paralelo). bit i = a carta i de A vence a carta i de B. */
+void compararBaralhos(const Baralho *a, const Baralho *b, uint64_t *mascaras[NUM_ATRIBUTOS]) {
+    INSTR_ESCOPO(compararBaralhos);
+    size_t n = a->n < b->n ? a->n : b->n;
+    for (int at = 0; at < NUM_ATRIBUTOS; at++)
+        kernelPar(a->col[at], b->col[at], n, maiorVence(at), mascaras[at]);
+}
+
+static inline int bitMascara(const uint64_t *mascara, size_t j) {
+    return (int)(mascara[j / BITS_MASCARA] >> (j % BITS_MASCARA) & 1);
+}
+
+/* ---------- Entrada e exibicao ---------- */
+
+void lerString(char *buf, int tam) {
+    if (fgets(buf, tam, stdin) == NULL) {
+        buf[0] = '\0';
+        return;
+    }
+    buf[strcspn(buf, "\n")] = '\0';
+}
+
+void limparBufferStdin(void) {
+    int c;
+    while ((c = getchar()) != '\n' && c != EOF);
+}
+
+/* Le um numero decimal do usuario direto para ponto fixo */
+int lerFixo(Fixo *dest) {
+    char buf[64];
+    char *fim;
+    if (scanf("%63s", buf) != 1) return 0;
+    *dest = textoParaFixo(buf, &fim);
+    return fim != buf && *fim == '\0';
+}
+
+int cadastrarCarta(Carta *c, int numero) {
+    printf("\n=== Cadastro da carta %d ===\n", numero);
+    printf("Estado (A-H): ");
+    if (scanf(" %c", &c->estado) != 1) return 0;
+    printf("Codigo da carta (ex: A01): ");
+    if (scanf("%3s", c->codigo) != 1) return 0;
+    limparBufferStdin();
+    printf("Nome da cidade: ");
+    lerString(c->nome, MAX_NOME);
+    printf("Populacao: ");
+    if (scanf("%lu", &c->populacao) != 1) return 0;
+    printf("Area (km2): ");
+    if (!lerFixo(&c->area)) return 0;
+    printf("PIB (bilhoes de reais): ");
+    if (!lerFixo(&c->pib)) return 0;
+    printf("Numero de pontos turisticos: ");
+    if (scanf("%d", &c->pontosTuristicos) != 1) return 0;
+    return 1;
+}
+
+void exibirCarta(const Baralho *b, size_t i) {
+    char num[TAM_TEXTO_FIXO];
+    printf("\nCarta %zu: %s (%c, codigo %s)\n", i + 1, b->nome[i], b->estado[i], b->codigo[i]);
+    for (int a = 0; a < NUM_ATRIBUTOS; a++)
+        printf("  %-24s %s\n", nomesAtributos[a], formatarFixo(num, sizeof(num), b->col[a][i], 2));
+}
+
+/* ---------- Benchmark ---------- */
+
+static uint64_t estadoAleatorio = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t proximoAleatorio(void) {
+    uint64_t x = estadoAleatorio;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    estadoAleatorio = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static double aleatorioEntre(double min, double max) {
+    return min + (max - min) * (double)(proximoAleatorio() >> 11) / 9007199254740992.0;
+}
+
+/* Fixo uniforme em [min, max) (min e max em unidades reais) */
+static Fixo aleatorioFixo(double min, double max) {
+    Fixo lo = (Fixo)(min * ESCALA_FIXO), hi = (Fixo)(max * ESCALA_FIXO);
+    return lo + (Fixo)(proximoAleatorio() % (uint64_t)(hi - lo));
+}
+
+void gerarCartaAleatoria(Carta *c, size_t i) {
+    c->estado = (char)('A' + i % 8);
+    snprintf(c->codigo, sizeof(c->codigo), "%c%02zu", c->estado, i % 100);
+    snprintf(c->nome, sizeof(c->nome), "Cidade %zu", i);
+    c->populacao = (unsigned long)aleatorioEntre(1e3, 1.2e7);
+    c->area = aleatorioFixo(1.0, 1.5e4);
+    c->pib = aleatorioFixo(0.01, 800.0);
+    c->pontosTuristicos = (int)aleatorioEntre(0, 100);
+}
+
+static inline uint64_t agoraNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Mede carta x baralho (kernel escolhido vs escalar vs a versao antiga
+   em double) e baralho x baralho, conferindo que os kernels concordam com
+   a referencia escalar e contando onde double e ponto fixo discordam. */
+int executarBench(size_t n) {
+    Baralho b, b2;
+    Carta c;
+    double valores[NUM_ATRIBUTOS], *flutuante[NUM_ATRIBUTOS];
+    iniciarBaralho(&b);
+    iniciarBaralho(&b2);
+    if (!reservarBaralho(&b, n) || !reservarBaralho(&b2, n)) { fprintf(stderr, "Erro de alocacao\n"); return 1; }
+    for (int a = 0; a < NUM_ATRIBUTOS; a++)
+        if (!(flutuante[a] = alocarAlinhado(n * sizeof(double)))) { fprintf(stderr, "Erro de alocacao\n"); return 1; }
+    for (size_t i = 0; i < n; i++) {
+        gerarCartaAleatoria(&c, i);
+        adicionarCarta(&b, &c);
+        calcularAtributosFlutuante(&c, valores);
+        for (int a = 0; a < NUM_ATRIBUTOS; a++) flutuante[a][i] = valores[a];
+        gerarCartaAleatoria(&c, i);
+        adicionarCarta(&b2, &c);
+    }
+
+    size_t palavras = palavrasMascara(n);
+    uint64_t *bloco = calloc(2 * NUM_ATRIBUTOS * palavras, sizeof(uint64_t));
+    if (!bloco) { fprintf(stderr, "Erro de alocacao\n"); return 1; }
+    uint64_t *mascaras[NUM_ATRIBUTOS], *referencia[NUM_ATRIBUTOS];
+    for (int a = 0; a < NUM_ATRIBUTOS; a++) {
+        mascaras[a] = bloco + (size_t)a * palavras;
+        referencia[a] = bloco + (size_t)(NUM_ATRIBUTOS + a) * palavras;
+    }
+
+    size_t rodadas = n >= 1000000 ? 20 : 20000000 / n + 1;
+    double comparacoes = (double)rodadas * n * NUM_ATRIBUTOS;
+    uint64_t vencidas = 0;
+
+    uint64_t t0 = agoraNs();
+    for (size_t r = 0; r < rodadas; r++) {
+        compararCartaBaralho(&b, r % n, mascaras);
+        vencidas += mascaras[ATR_SUPER_PODER][0];
+    }
+    double msSimd = (agoraNs() - t0) / 1e6;
+
+    t0 = agoraNs();
+    for (size_t r = 0; r < rodadas; r++) {
+        for (int a = 0; a < NUM_ATRIBUTOS; a++)
+            kernelEscalar(b.col[a], n, b.col[a][r % n], maiorVence(a), referencia[a]);
+        vencidas += referencia[ATR_SUPER_PODER][0];
+    }
+    double msEscalar = (agoraNs() - t0) / 1e6;
+
+    int confere = 1;
+    for (int a = 0; a < NUM_ATRIBUTOS; a++)
+        if (memcmp(mascaras[a], referencia[a], palavras * sizeof(uint64_t)) != 0) confere = 0;
+
+    t0 = agoraNs();
+    for (size_t r = 0; r < rodadas; r++) {
+        for (int a = 0; a < NUM_ATRIBUTOS; a++)
+            kernelFlutuante(flutuante[a], n, flutuante[a][r % n], maiorVence(a), referencia[a]);
+        vencidas += referencia[ATR_SUPER_PODER][0];
+    }
+    double msFlutuante = (agoraNs() - t0) / 1e6;
+
+    /* resultados que mudam entre double e ponto fixo (em algumas cartas) */
+    uint64_t discordancias = 0;
+    size_t amostras = rodadas < 20 ? rodadas : 20;
+    for (size_t r = 0; r < amostras; r++) {
+        compararCartaBaralho(&b, r % n, mascaras);
+        for (int a = 0; a < NUM_ATRIBUTOS; a++) {
+            kernelFlutuante(flutuante[a], n, flutuante[a][r % n], maiorVence(a), referencia[a]);
+            for (size_t w = 0; w < palavras; w++)
+                discordancias += (uint64_t)__builtin_popcountll(mascaras[a][w] ^ referencia[a][w]);
+        }
+    }
+
+    t0 = agoraNs();
+    for (size_t r = 0; r < rodadas; r++) compararBaralhos(&b, &b2, mascaras);
+    double msPar = (agoraNs() - t0) / 1e6;
+
+    printf("Baralho: %zu cartas, %d atributos, kernel %s\n", n, NUM_ATRIBUTOS, nomeKernel);
+    printf("Carta x baralho (%s, ponto fixo): %.1f ms, %.1f milhoes de comparacoes/ms\n",
+           nomeKernel, msSimd, comparacoes / msSimd / 1e6);
+    printf("Carta x baralho (escalar, ponto fixo): %.1f ms, %.1f milhoes de comparacoes/ms\n",
+           msEscalar, comparacoes / msEscalar / 1e6);
+    printf("Carta x baralho (%s, double): %.1f ms, %.1f milhoes de comparacoes/ms\n",
+           kernelFlutuante == kernelFlutuanteEscalar ? "escalar" : nomeKernel,
+           msFlutuante, comparacoes / msFlutuante / 1e6);
+    printf("Baralho x baralho (%s, ponto fixo): %.1f ms, %.1f milhoes de comparacoes/ms\n",
+           nomeKernel, msPar, comparacoes / msPar / 1e6);
+    printf("Double x ponto fixo: %llu resultados diferentes em %zu cartas x baralho\n",
+           (unsigned long long)discordancias, amostras);
+    printf("Mascaras conferem com a referencia: %s (%llu)\n", confere ? "sim" : "NAO",
+           (unsigned long long)(vencidas & 0xFF));
+
+    for (int a = 0; a < NUM_ATRIBUTOS; a++) free(flutuante[a]);
+    free(bloco);
+    liberarBaralho(&b);
+    liberarBaralho(&b2);
+    return confere ? 0 : 1;
+}
+
+/* ---------- Torneio todos contra todos ---------- */
+
+/* Regra customizada: a carta i vence j se sum(peso[a] * s_a) > 0, onde
+   s_a = +1 se i vence no atributo a, -1 se perde e 0 se empata. Os pesos
+   sao Fixo e a soma e inteira, entao soma zero e empate (nao vitoria). */
+#define PESO_MAX (INT64_MAX / NUM_ATRIBUTOS)   /* soma nunca transborda */
+
+typedef struct {
+    Fixo peso[NUM_ATRIBUTOS];
+} Regra;
+
+typedef struct {
+    void (*tarefa)(void *ctx, size_t i);
+    void *ctx;
+    size_t total;
+    atomic_size_t proximo;
+} TrabalhoParalelo;
+
+static void *trabalhadorParalelo(void *arg) {
+    TrabalhoParalelo *t = arg;
+    size_t i;
+    while ((i = atomic_fetch_add(&t->proximo, 1)) < t->total) t->tarefa(t->ctx, i);
+    return NULL;
+}
+
+/* Executa tarefa(ctx, i) para i em [0, total) em numThreads threads
+   (a chamadora inclusa), distribuindo indices por contador atomico */
+void executarEmParalelo(int numThreads, void (*tarefa)(void *, size_t), void *ctx, size_t total) {
+    TrabalhoParalelo t = { tarefa, ctx, total, 0 };
+    pthread_t *threads = numThreads > 1 ? malloc((size_t)(numThreads - 1) * sizeof(pthread_t)) : NULL;
+    int criadas = 0;
+    for (int i = 0; threads && i < numThreads - 1; i++)
+        if (pthread_create(&threads[i], NULL, trabalhadorParalelo, &t) == 0) criadas++;
+    trabalhadorParalelo(&t);
+    for (int i = 0; i < criadas; i++) pthread_join(threads[i], NULL);
+    free(threads);
+}
+
+static int compararFixo(const void *a, const void *b) {
+    Fixo x = *(const Fixo *)a, y = *(const Fixo *)b;
+    return (x > y) - (x < y);
+}
+
+/* Quantos valores do vetor ordenado sao < v (ou <= v com inclusivo) */
+static size_t contarAbaixo(const Fixo *ord, size_t n, Fixo v, int inclusivo) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t meio = lo + (hi - lo) / 2;
+        if (ord[meio] < v || (inclusivo && ord[meio] == v)) lo = meio + 1;
+        else hi = meio;
+    }
+    return lo;
+}
+
+typedef struct {
+    const Baralho *b;
+    uint32_t *vitorias[NUM_ATRIBUTOS];
+    atomic_int erro;
+} ContextoOrdenacao;
+
+/* Vitorias exatas de cada carta no atributo a: ordena uma copia da coluna
+   e, para cada carta, conta por busca binaria quantas ela supera. */
+static void vitoriasPorOrdenacao(void *arg, size_t a) {
+    ContextoOrdenacao *ctx = arg;
+    const Baralho *b = ctx->b;
+    Fixo *ord = malloc(b->n * sizeof(Fixo));
+    if (!ord) { atomic_store(&ctx->erro, 1); return; }
+    memcpy(ord, b->col[a], b->n * sizeof(Fixo));
+    qsort(ord, b->n, sizeof(Fixo), compararFixo);
+    for (size_t i = 0; i < b->n; i++) {
+        Fixo v = b->col[a][i];
+        ctx->vitorias[a][i] = (uint32_t)(maiorVence((int)a)
+            ? contarAbaixo(ord, b->n, v, 0)
+            : b->n - contarAbaixo(ord, b->n, v, 1));
+    }
+    free(ord);
+}
+
+/* Resultado do torneio em CSV. Com regra, as linhas de cada bloco saem
+   assim que o bloco e todos os anteriores terminam: quem conclui um bloco
+   grava, sob a trava, a sequencia de blocos prontos a partir de proximo. */
+typedef struct {
+    FILE *out;
+    const Baralho *b;
+    uint32_t *const *vitorias;
+    const uint32_t *vitoriasRegra;
+    pthread_mutex_t trava;
+    unsigned char *pronto;             /* um por bloco de BLOCO_I linhas */
+    size_t proximo;
+} SaidaTorneio;
+
+/* Cria o arquivo e grava o cabecalho; vitoriasRegra NULL omite a coluna */
+int abrirSaidaTorneio(SaidaTorneio *s, const char *arquivo, const Baralho *b,
+                      uint32_t *const vitorias[NUM_ATRIBUTOS], const uint32_t *vitoriasRegra) {
+    memset(s, 0, sizeof(*s));
+    s->b = b;
+    s->vitorias = vitorias;
+    s->vitoriasRegra = vitoriasRegra;
+    s->pronto = calloc((b->n + BLOCO_I - 1) / BLOCO_I + 1, 1);
+    if (!s->pronto) return 0;
+    s->out = fopen(arquivo, "w");
+    if (!s->out) { free(s->pronto); return 0; }
+    setvbuf(s->out, NULL, _IOFBF, 1 << 20);
+    pthread_mutex_init(&s->trava, NULL);
+    fprintf(s->out, "indice,codigo,nome");
+    for (int a = 0; a < NUM_ATRIBUTOS; a++) fprintf(s->out, ",%s", nomesAtributos[a]);
+    fprintf(s->out, vitoriasRegra ? ",Regra\n" : "\n");
+    return 1;
+}
+
+static void gravarLinhasTorneio(SaidaTorneio *s, size_t i0, size_t i1) {
+    const Baralho *b = s->b;
+    for (size_t i = i0; i < i1; i++) {
+        fprintf(s->out, "%zu,%s,%s", i, b->codigo[i], b->nome[i]);
+        for (int a = 0; a < NUM_ATRIBUTOS; a++) fprintf(s->out, ",%u", s->vitorias[a][i]);
+        if (s->vitoriasRegra) fprintf(s->out, ",%u", s->vitoriasRegra[i]);
+        fputc('\n', s->out);
+    }
+}
+
+/* Marca o bloco como pronto e grava os blocos consecutivos ja concluidos */
+static void concluirBlocoTorneio(SaidaTorneio *s, size_t bloco) {
+    pthread_mutex_lock(&s->trava);
+    s->pronto[bloco] = 1;
+    while (s->pronto[s->proximo]) {
+        size_t i0 = s->proximo * BLOCO_I;
+        gravarLinhasTorneio(s, i0, i0 + BLOCO_I < s->b->n ? i0 + BLOCO_I : s->b->n);
+        s->proximo++;
+    }
+    pthread_mutex_unlock(&s->trava);
+}
+
+/* Grava as linhas ainda pendentes (todas, sem regra) e fecha o arquivo */
+int fecharSaidaTorneio(SaidaTorneio *s) {
+    gravarLinhasTorneio(s, s->proximo * BLOCO_I < s->b->n ? s->proximo * BLOCO_I : s->b->n, s->b->n);
+    int ok = !ferror(s->out);
+    ok = fclose(s->out) == 0 && ok;
+    pthread_mutex_destroy(&s->trava);
+    free(s->pronto);
+    return ok;
+}
+
+typedef struct {
+    const Baralho *b;
+    Fixo pesoSinal[NUM_ATRIBUTOS];     /* peso com sinal trocado na densidade */
+    uint32_t *vitorias;
+    SaidaTorneio *saida;               /* NULL: so calcula */
+} ContextoTodosPares;
+
+/* Linhas [i0, i0+BLOCO_I) contra todas as cartas, em ladrilhos de BLOCO_J
+   colunas reaproveitados pelas linhas do bloco. Cada tarefa escreve so
+   nas suas linhas, sem sincronizacao. */
+static void blocoTodosPares(void *arg, size_t bloco) {
+    INSTR_ESCOPO(blocoTodosPares);
+    ContextoTodosPares *ctx = arg;
+    const Baralho *b = ctx->b;
+    size_t i0 = bloco * BLOCO_I, i1 = i0 + BLOCO_I < b->n ? i0 + BLOCO_I : b->n;
+    _Alignas(32) int64_t pontos[BLOCO_J];
+    for (size_t i = i0; i < i1; i++) ctx->vitorias[i] = 0;
+    for (size_t j0 = 0; j0 < b->n; j0 += BLOCO_J) {
+        size_t len = j0 + BLOCO_J < b->n ? BLOCO_J : b->n - j0;
+        for (size_t i = i0; i < i1; i++) {
+            memset(pontos, 0, len * sizeof(int64_t));
+            for (int a = 0; a < NUM_ATRIBUTOS; a++) {
+                Fixo w = ctx->pesoSinal[a];
+                if (w == 0) continue;
+                Fixo vi = b->col[a][i];
+                const Fixo *c = b->col[a] + j0;
+                kernelPontos(c, len, vi, w, pontos);
+            }
+            uint32_t vence = 0;
+            for (size_t j = 0; j < len; j++) vence += pontos[j] > 0;
+            ctx->vitorias[i] += vence;
+        }
+    }
+    if (ctx->saida) concluirBlocoTorneio(ctx->saida, bloco);
+}
+
+void vitoriasTodosPares(const Baralho *b, const Regra *r, uint32_t *vitorias, SaidaTorneio *saida, int numThreads) {
+    ContextoTodosPares ctx;
+    ctx.b = b;
+    ctx.vitorias = vitorias;
+    ctx.saida = saida;
+    for (int a = 0; a < NUM_ATRIBUTOS; a++) ctx.pesoSinal[a] = maiorVence(a) ? r->peso[a] : -r->peso[a];
+    executarEmParalelo(numThreads, blocoTodosPares, &ctx, (b->n + BLOCO_I - 1) / BLOCO_I);
+}
+
+int executarTorneio(Baralho *b, const Regra *regra, const char *arquivo, int numThreads) {
+    size_t n = b->n;
+    ContextoOrdenacao ctx;
+    uint32_t *vitoriasRegra = NULL;
+    int ok = 1;
+    ctx.b = b;
+    atomic_init(&ctx.erro, 0);
+    uint32_t *bloco = malloc((size_t)NUM_ATRIBUTOS * n * sizeof(uint32_t));
+    if (!bloco) { fprintf(stderr, "Erro de alocacao\n"); return 1; }
+    for (int a = 0; a < NUM_ATRIBUTOS; a++) ctx.vitorias[a] = bloco + (size_t)a * n;
+
+    uint64_t t0 = agoraNs();
+    executarEmParalelo(numThreads, vitoriasPorOrdenacao, &ctx, NUM_ATRIBUTOS);
+    double msOrdenacao = (agoraNs() - t0) / 1e6;
+    if (atomic_load(&ctx.erro)) { fprintf(stderr, "Erro de alocacao\n"); free(bloco); return 1; }
+    printf("Torneio: %zu cartas, %d threads, kernel %s\n", n, numThreads, nomeKernel);
+    printf("Por ordenacao (O(N log N), %d atributos): %.1f ms\n", NUM_ATRIBUTOS, msOrdenacao);
+
+    if (regra) {
+        vitoriasRegra = malloc(n * sizeof(uint32_t));
+        if (!vitoriasRegra) { fprintf(stderr, "Erro de alocacao\n"); free(bloco); return 1; }
+    }
+    /* Aberto antes dos pares para que cada bloco seja gravado ao terminar */
+    SaidaTorneio saida;
+    int gravando = arquivo != NULL;
+    if (gravando && !abrirSaidaTorneio(&saida, arquivo, b, ctx.vitorias, vitoriasRegra)) {
+        fprintf(stderr, "Erro ao gravar %s\n", arquivo);
+        gravando = 0;
+        ok = 0;
+    }
+
+    if (regra) {
+        t0 = agoraNs();
+        vitoriasTodosPares(b, regra, vitoriasRegra, gravando ? &saida : NULL, numThreads);
+        double msPares = (agoraNs() - t0) / 1e6;
+        double pares = (double)n * n;
+        printf("Todos os pares em blocos (regra customizada): %.1f ms, %.1f milhoes de pares/ms\n",
+               msPares, pares / msPares / 1e6);
+
+        /* Confere os dois caminhos: regra so com super poder = ordenacao */
+        if (n <= LIMITE_CONFERENCIA) {
+            Regra so = {{0}};
+            so.peso[ATR_SUPER_PODER] = ESCALA_FIXO;
+            uint32_t *conf = malloc(n * sizeof(uint32_t));
+            if (conf) {
+                vitoriasTodosPares(b, &so, conf, NULL, numThreads);
+                int conferem = memcmp(conf, ctx.vitorias[ATR_SUPER_PODER], n * sizeof(uint32_t)) == 0;
+                printf("Todos os pares x ordenacao (super poder): %s\n", conferem ? "conferem" : "DIVERGEM");
+                ok = ok && conferem;
+                free(conf);
+            }
+        }
+    }
+
+    size_t melhor = 0;
+    for (size_t i = 1; i < n; i++)
+        if (ctx.vitorias[ATR_SUPER_PODER][i] > ctx.vitorias[ATR_SUPER_PODER][melhor]) melhor = i;
+    if (n) printf("Maior super poder: %s (%s), vence %u de %zu\n", b->nome[melhor], b->codigo[melhor],
+                  ctx.vitorias[ATR_SUPER_PODER][melhor], n - 1);
+
+    if (gravando) {
+        t0 = agoraNs();
+        if (!fecharSaidaTorneio(&saida)) {
+            fprintf(stderr, "Erro ao gravar %s\n", arquivo);
+            ok = 0;
+        } else {
+            printf("Resultado gravado em %s (%.1f ms apos o calculo)\n", arquivo, (agoraNs() - t0) / 1e6);
+        }
+    }
+    free(vitoriasRegra);
+    free(bloco);
+    return ok ? 0 : 1;
+}
+
+/* Le "p1,p2,...,p7" direto em Fixo; |p| <= PESO_MAX */
+int lerRegra(const char *texto, Regra *r) {
+    char *fim;
+    for (int a = 0; a < NUM_ATRIBUTOS; a++) {
+        r->peso[a] = textoParaFixo(texto, &fim);
+        if (fim == texto || r->peso[a] > PESO_MAX || r->peso[a] < -PESO_MAX) return 0;
+        texto = fim;
+        if (a < NUM_ATRIBUTOS - 1) {
+            if (*texto != ',') return 0;
+            texto++;
+        }
+    }
+    return *texto == '\0';
+}
+
+int gerarBaralho(Baralho *b, size_t n) {
+    Carta c;
+    if (!reservarBaralho(b, n)) return 0;
+    for (size_t i = 0; i < n; i++) {
+        gerarCartaAleatoria(&c, i);
+        adicionarCarta(b, &c);
+    }
+    return 1;
+}
+
+/* ---------- Indices de ranking ---------- */
+
+/* Para cada atributo, as cartas em ordem crescente de valor (empates por
+   indice). Com isso:
+   - quantas cartas X vence / quem vence X: busca binaria, O(log N), e as
+     cartas que vencem X formam um trecho contiguo de carta[a];
+   - top k: as k pontas do vetor, O(k).
+   Sem indice, o top k de uma coluna sai de um heap de k elementos. */
+typedef struct {
+    size_t n;
+    Fixo *valor[NUM_ATRIBUTOS];
+    uint32_t *carta[NUM_ATRIBUTOS];
+} IndiceRanking;
+
+typedef struct {
+    uint64_t chave;
+    uint32_t carta;
+} ParOrdenacao;
+
+/* int64 -> uint64 com a mesma ordem: basta inverter o bit de sinal */
+static inline uint64_t chaveOrdenavel(Fixo v) {
+    return (uint64_t)v ^ 0x8000000000000000ULL;
+}
+
+typedef struct {
+    const Baralho *b;
+    IndiceRanking *r;
+    atomic_int erro;
+} ContextoIndice;
+
+/* Ordena um atributo: radix LSD estavel em 4 passadas de 16 bits sobre
+   pares (chave, carta); passadas com um unico balde sao puladas. */
+static void construirIndiceAtributo(void *arg, size_t a) {
+    ContextoIndice *ctx = arg;
+    size_t n = ctx->b->n;
+    const Fixo *col = ctx->b->col[a];
+    ParOrdenacao *pares = malloc(n * sizeof(ParOrdenacao));
+    ParOrdenacao *aux = malloc(n * sizeof(ParOrdenacao));
+    size_t *contagem = malloc(65536 * sizeof(size_t));
+    if (!pares || !aux || !contagem) {
+        free(pares); free(aux); free(contagem);
+        atomic_store(&ctx->erro, 1);
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        pares[i].chave = chaveOrdenavel(col[i]);
+        pares[i].carta = (uint32_t)i;
+    }
+    for (int desloc = 0; desloc < 64; desloc += 16) {
+        memset(contagem, 0, 65536 * sizeof(size_t));
+        for (size_t i = 0; i < n; i++) contagem[(pares[i].chave >> desloc) & 0xFFFF]++;
+        if (n && contagem[(pares[0].chave >> desloc) & 0xFFFF] == n) continue;
+        size_t soma = 0;
+        for (size_t d = 0; d < 65536; d++) {
+            size_t c = contagem[d];
+            contagem[d] = soma;
+            soma += c;
+        }
+        for (size_t i = 0; i < n; i++) aux[contagem[(pares[i].chave >> desloc) & 0xFFFF]++] = pares[i];
+        ParOrdenacao *t = pares;
+        pares = aux;
+        aux = t;
+    }
+    for (size_t i = 0; i < n; i++) {
+        ctx->r->carta[a][i] = pares[i].carta;
+        ctx->r->valor[a][i] = col[pares[i].carta];
+    }
+    free(pares);
+    free(aux);
+    free(contagem);
+}
+
+void liberarIndice(IndiceRanking *r) {
+    for (int a = 0; a < NUM_ATRIBUTOS; a++) {
+        free(r->valor[a]);
+        free(r->carta[a]);
+    }
+    memset(r, 0, sizeof(*r));
+}
+
+int construirIndice(const Baralho *b, IndiceRanking *r, int numThreads) {
+    ContextoIndice ctx;
+    memset(r, 0, sizeof(*r));
+    r->n = b->n;
+    for (int a = 0; a < NUM_ATRIBUTOS; a++) {
+        r->valor[a] = malloc((b->n ? b->n : 1) * sizeof(Fixo));
+        r->carta[a] = malloc((b->n ? b->n : 1) * sizeof(uint32_t));
+        if (!r->valor[a] || !r->carta[a]) { liberarIndice(r); return 0; }
+    }
+    ctx.b = b;
+    ctx.r = r;
+    atomic_init(&ctx.erro, 0);
+    executarEmParalelo(numThreads, construirIndiceAtributo, &ctx, NUM_ATRIBUTOS);
+    if (atomic_load(&ctx.erro)) { liberarIndice(r); return 0; }
+    return 1;
+}
+
+/* Quantas cartas um valor v vence no atributo a */
+size_t vitoriasIndice(const IndiceRanking *r, int a, Fixo v) {
+    INSTR_ESCOPO(vitoriasIndice);
+    return maiorVence(a) ? contarAbaixo(r->valor[a], r->n, v, 0)
+                         : r->n - contarAbaixo(r->valor[a], r->n, v, 1);
+}
+
+/* Cartas que vencem o valor v no atributo a: devolve a quantidade e, em
+   *lista, o inicio do trecho em r->carta[a] (sem copia). O trecho esta em
+   ordem crescente de valor, entao a carta mais proxima de v e a primeira
+   quando o maior vence e a ultima quando o menor vence (densidade). */
+size_t quemVence(const IndiceRanking *r, int a, Fixo v, const uint32_t **lista) {
+    if (maiorVence(a)) {
+        size_t inicio = contarAbaixo(r->valor[a], r->n, v, 1);
+        *lista = r->carta[a] + inicio;
+        return r->n - inicio;
+    }
+    *lista = r->carta[a];
+    return contarAbaixo(r->valor[a], r->n, v, 0);
+}
+
+/* As k melhores cartas no atributo a, da melhor para a pior */
+size_t topKIndice(const IndiceRanking *r, int a, size_t k, uint32_t *saida) {
+    if (k > r->n) k = r->n;
+    for (size_t i = 0; i < k; i++)
+        saida[i] = maiorVence(a) ? r->carta[a][r->n - 1 - i] : r->carta[a][i];
+    return k;
+}
+
+/* "x e pior que y" no atributo (para o heap: a raiz e a pior das k) */
+static inline int piorQue(int maior, Fixo x, Fixo y) {
+    return maior ? x < y : x > y;
+}
+
+static void descerHeap(const Fixo *col, int maior, uint32_t *heap, size_t k, size_t i) {
+    for (;;) {
+        size_t e = 2 * i + 1, d = e + 1, m = i;
+        if (e < k && piorQue(maior, col[heap[e]], col[heap[m]])) m = e;
+        if (d < k && piorQue(maior, col[heap[d]], col[heap[m]])) m = d;
+        if (m == i) return;
+        uint32_t t = heap[i]; heap[i] = heap[m]; heap[m] = t;
+        i = m;
+    }
+}
+
+/* Top k sem indice: heap das k melhores vistas, O(N log k) */
+size_t topKHeap(const Baralho *b, int a, size_t k, uint32_t *saida) {
+    const Fixo *col = b->col[a];
+    int maior = maiorVence(a);
+    size_t tam = 0;
+    if (k > b->n) k = b->n;
+    if (!k) return 0;
+    for (size_t j = 0; j < b->n; j++) {
+        if (tam < k) {
+            saida[tam++] = (uint32_t)j;
+            if (tam == k)
+                for (size_t i = k / 2; i-- > 0;) descerHeap(col, maior, saida, k, i);
+        } else if (piorQue(maior, col[saida[0]], col[j])) {
+            saida[0] = (uint32_t)j;
+            descerHeap(col, maior, saida, k, 0);
+        }
+    }
+    /* extrai a pior de cada vez para o fim: sai da melhor para a pior */
+    for (size_t fim = k; fim > 1; fim--) {
+        uint32_t t = saida[0]; saida[0] = saida[fim - 1]; saida[fim - 1] = t;
+        descerHeap(col, maior, saida, fim - 1, 0);
+    }
+    return k;
+}
+
+/* Varredura como no esqueleto do desafio: um if/else por carta */
+static size_t vitoriasLinear(const Baralho *b, int a, Fixo v) {
+    const Fixo *col = b->col[a];
+    size_t vence = 0;
+    for (size_t j = 0; j < b->n; j++) {
+        if (maiorVence(a)) {
+            if (v > col[j]) vence++;
+        } else {
+            if (v < col[j]) vence++;
+        }
+    }
+    return vence;
+}
+
+/* Varredura com o kernel SIMD de mascaras + popcount */
+static size_t vitoriasMascara(const Baralho *b, int a, Fixo v, uint64_t *mascara) {
+    size_t vence = 0;
+    kernelCarta(b->col[a], b->n, v, maiorVence(a), mascara);
+    for (size_t w = 0; w < palavrasMascara(b->n); w++) vence += (size_t)__builtin_popcountll(mascara[w]);
+    return vence;
+}
+
+int executarRanking(const Baralho *b, size_t consultas, int numThreads) {
+    IndiceRanking r;
+    uint32_t top1[10], top2[10];
+    char num[TAM_TEXTO_FIXO];
+    uint64_t *mascara = malloc(palavrasMascara(b->n) * sizeof(uint64_t) + sizeof(uint64_t));
+    size_t n = b->n;
+    if (!mascara || !n) { free(mascara); fprintf(stderr, "Baralho vazio ou erro de alocacao\n"); return 1; }
+
+    uint64_t t0 = agoraNs();
+    if (!construirIndice(b, &r, numThreads)) { free(mascara); fprintf(stderr, "Erro de alocacao\n"); return 1; }
+    double msIndice = (agoraNs() - t0) / 1e6;
+    printf("Ranking: %zu cartas, %zu consultas, kernel %s\n", n, consultas, nomeKernel);
+    printf("Construcao dos indices (%d atributos, %d threads): %.1f ms\n", NUM_ATRIBUTOS, numThreads, msIndice);
+
+    /* quantas cartas X vence: indice x varredura */
+    size_t *cartas = malloc(consultas * sizeof(size_t));
+    if (!cartas) { liberarIndice(&r); free(mascara); return 1; }
+    for (size_t q = 0; q < consultas; q++) cartas[q] = (size_t)(proximoAleatorio() % n);
+    size_t divergencias = 0, total[3] = {0, 0, 0};
+    uint64_t ns[3] = {0, 0, 0};
+    for (int modo = 0; modo < 3; modo++) {
+        t0 = agoraNs();
+        for (size_t q = 0; q < consultas; q++) {
+            int a = (int)(q % NUM_ATRIBUTOS);
+            Fixo v = b->col[a][cartas[q]];
+            size_t c = modo == 0 ? vitoriasIndice(&r, a, v)
+                     : modo == 1 ? vitoriasLinear(b, a, v)
+                     : vitoriasMascara(b, a, v, mascara);
+            total[modo] += c;
+            if (modo > 0 && c != vitoriasIndice(&r, a, v)) divergencias++;
+        }
+        ns[modo] = agoraNs() - t0;
+    }
+    printf("Vitorias de uma carta: indice %.3f us, linear if/else %.1f us, mascara SIMD %.1f us por consulta\n",
+           ns[0] / 1e3 / consultas, ns[1] / 1e3 / consultas, ns[2] / 1e3 / consultas);
+
+    /* top 10 por atributo: indice x heap */
+    uint64_t nsIndice = 0, nsHeap = 0;
+    for (int a = 0; a < NUM_ATRIBUTOS; a++) {
+        t0 = agoraNs();
+        size_t k = topKIndice(&r, a, 10, top1);
+        nsIndice += agoraNs() - t0;
+        t0 = agoraNs();
+        topKHeap(b, a, 10, top2);
+        nsHeap += agoraNs() - t0;
+        for (size_t i = 0; i < k; i++)
+            if (b->col[a][top1[i]] != b->col[a][top2[i]]) divergencias++;
+    }
+    printf("Top 10 por atributo: indice %.3f us, heap sem indice %.1f us\n",
+           nsIndice / 1e3 / NUM_ATRIBUTOS, nsHeap / 1e3 / NUM_ATRIBUTOS);
+
+    topKIndice(&r, ATR_PIB_PER_CAPITA, 10, top1);
+    printf("\nTop 10 por %s:\n", nomesAtributos[ATR_PIB_PER_CAPITA]);
+    for (int i = 0; i < 10 && (size_t)i < n; i++)
+        printf("  %2d. %-20s %s\n", i + 1, b->nome[top1[i]],
+               formatarFixo(num, sizeof(num), b->col[ATR_PIB_PER_CAPITA][top1[i]], 2));
+    const uint32_t *lista;
+    const int exemplos[] = { ATR_POPULACAO, ATR_DENSIDADE };   /* maior e menor vence */
+    for (int e = 0; e < 2; e++) {
+        int a = exemplos[e];
+        size_t qtd = quemVence(&r, a, b->col[a][0], &lista);
+        printf("Cartas que vencem %s em %s: %zu%s%s\n", b->nome[0], nomesAtributos[a], qtd,
+               qtd ? ", a mais proxima: " : "", qtd ? b->nome[lista[maiorVence(a) ? 0 : qtd - 1]] : "");
+    }
+
+    printf("Conferencia com as varreduras: %s\n", divergencias ? "DIVERGEM" : "conferem");
+    free(cartas);
+    free(mascara);
+    liberarIndice(&r);
+    return divergencias ? 1 : 0;
+}
+
+/* ---------- Arquivo binario de cartas ---------- */
+
+/* Formato (ordem de bytes da maquina, conferida pelo campo ordem):
+   cabecalho | 7 colunas Fixo | estado[n] | codigo[n][4] | nome[n][50]
+   Cada secao comeca em deslocamento multiplo de 64, entao, com o arquivo
+   mapeado em endereco de pagina, as colunas ja saem alinhadas para os
+   kernels e o Baralho aponta direto para o mapa, sem copia nem parsing. */
+#define MAGICO_BARALHO "STRUNFO"
+#define VERSAO_BARALHO 2          /* 2: colunas em ponto fixo (era double) */
+#define ORDEM_BYTES 0x01020304u
+
+typedef struct {
+    char magico[8];
+    uint32_t versao;
+    uint32_t ordem;
+    uint32_t numAtributos;
+    uint32_t tamNome;
+    uint64_t escala;
+    uint64_t n;
+    uint64_t deslocCol[NUM_ATRIBUTOS];
+    uint64_t deslocEstado, deslocCodigo, deslocNome;
+    uint64_t tamArquivo;
+} CabecalhoBaralho;
+
+static uint64_t alinharDesloc(uint64_t x) {
+    return (x + ALINHAMENTO - 1) / ALINHAMENTO * ALINHAMENTO;
+}
+
+static void montarCabecalho(CabecalhoBaralho *c, uint64_t n) {
+    uint64_t pos = alinharDesloc(sizeof(*c));
+    memset(c, 0, sizeof(*c));
+    memcpy(c->magico, MAGICO_BARALHO, sizeof(MAGICO_BARALHO));
+    c->versao = VERSAO_BARALHO;
+    c->ordem = ORDEM_BYTES;
+    c->numAtributos = NUM_ATRIBUTOS;
+    c->tamNome = MAX_NOME;
+    c->escala = ESCALA_FIXO;
+    c->n = n;
+    for (int a = 0; a < NUM_ATRIBUTOS; a++) {
+        c->deslocCol[a] = pos;
+        pos = alinharDesloc(pos + n * sizeof(Fixo));
+    }
+    c->deslocEstado = pos;
+    c->deslocCodigo = pos = alinharDesloc(pos + n);
+    c->deslocNome = pos = alinharDesloc(pos + n * 4);
+    c->tamArquivo = pos + n * MAX_NOME;
+}
+
+static int gravarSecao(FILE *f, uint64_t desloc, const void *dados, size_t tam) {
+    static const char zeros[ALINHAMENTO];
+    long pos = ftell(f);
+    if (pos < 0 || (uint64_t)pos > desloc) return 0;
+    if (fwrite(zeros, 1, (size_t)(desloc - (uint64_t)pos), f) != desloc - (uint64_t)pos) return 0;
+    return tam == 0 || fwrite(dados, 1, tam, f) == tam;
+}
+
+int gravarBaralhoBinario(const char *arquivo, const Baralho *b) {
+    CabecalhoBaralho c;
+    FILE *f = fopen(arquivo, "wb");
+    if (!f) return 0;
+    montarCabecalho(&c, b->n);
+    int ok = fwrite(&c, sizeof(c), 1, f) == 1;
+    for (int a = 0; ok && a < NUM_ATRIBUTOS; a++)
+        ok = gravarSecao(f, c.deslocCol[a], b->col[a], b->n * sizeof(Fixo));
+    ok = ok && gravarSecao(f, c.deslocEstado, b->estado, b->n);
+    ok = ok && gravarSecao(f, c.deslocCodigo, b->codigo, b->n * sizeof(b->codigo[0]));
+    ok = ok && gravarSecao(f, c.deslocNome, b->nome, b->n * sizeof(b->nome[0]));
+    return fclose(f) == 0 && ok;
+}
+
+/* Mapeia o arquivo e aponta as colunas do baralho para ele. Confere
+   cabecalho e limites antes de confiar nos deslocamentos. */
+int mapearBaralho(const char *arquivo, Baralho *b) {
+    struct stat st;
+    int fd = open(arquivo, O_RDONLY);
+    if (fd < 0) return 0;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(CabecalhoBaralho)) { close(fd); return 0; }
+    void *mapa = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapa == MAP_FAILED) return 0;
+
+    const CabecalhoBaralho *c = mapa;
+    CabecalhoBaralho esperado;
+    montarCabecalho(&esperado, c->n);
+    if (memcmp(c->magico, MAGICO_BARALHO, sizeof(MAGICO_BARALHO)) != 0 || c->versao != VERSAO_BARALHO
+        || c->ordem != ORDEM_BYTES || c->n > (uint64_t)st.st_size
+        || memcmp(c, &esperado, sizeof(esperado)) != 0 || c->tamArquivo > (uint64_t)st.st_size) {
+        munmap(mapa, (size_t)st.st_size);
+        return 0;
+    }
+
+    char *base = mapa;
+    iniciarBaralho(b);
+    b->n = b->cap = (size_t)c->n;
+    for (int a = 0; a < NUM_ATRIBUTOS; a++) b->col[a] = (Fixo *)(void *)(base + c->deslocCol[a]);
+    b->estado = base + c->deslocEstado;
+    b->codigo = (char (*)[4])(void *)(base + c->deslocCodigo);
+    b->nome = (char (*)[MAX_NOME])(void *)(base + c->deslocNome);
+    b->mapa = mapa;
+    b->tamMapa = (size_t)st.st_size;
+    return 1;
+}
+
+/* Copia um campo do CSV ate a virgula (ou fim de linha) */
+static const char *campoCsv(const char *p, char *dest, size_t tam) {
+    size_t k = 0;
+    while (*p && *p != ',' && *p != '\n' && *p != '\r') {
+        if (k + 1 < tam) dest[k++] = *p;
+        p++;
+    }
+    dest[k] = '\0';
+    return *p == ',' ? p + 1 : NULL;
+}
+
+/* Uma linha: estado,codigo,nome,populacao,area,pib,pontos */
+static int lerLinhaCsv(const char *linha, Carta *c) {
+    char campo[MAX_NOME];
+    char *fim;
+    const char *p = campoCsv(linha, campo, sizeof(campo));
+    if (!p || !campo[0]) return 0;
+    c->estado = campo[0];
+    if (!(p = campoCsv(p, c->codigo, sizeof(c->codigo)))) return 0;
+    if (!(p = campoCsv(p, c->nome, sizeof(c->nome)))) return 0;
+    c->populacao = strtoul(p, &fim, 10);
+    if (fim == p || *fim != ',') return 0;
+    c->area = textoParaFixo(p = fim + 1, &fim);
+    if (fim == p || *fim != ',') return 0;
+    c->pib = textoParaFixo(p = fim + 1, &fim);
+    if (fim == p || *fim != ',') return 0;
+    c->pontosTuristicos = (int)strtol(p = fim + 1, &fim, 10);
+    return fim != p;
+}
+
+/* Le o CSV inteiro (cabecalho opcional). Devolve o numero da primeira
+   linha invalida, 0 em sucesso ou -1 se o arquivo nao abrir. */
+long carregarCsv(const char *arquivo, Baralho *b) {
+    char linha[256];
+    Carta c;
+    long num = 0;
+    FILE *f = fopen(arquivo, "r");
+    if (!f) return -1;
+    setvbuf(f, NULL, _IOFBF, 1 << 20);
+    while (fgets(linha, sizeof(linha), f)) {
+        num++;
+        if (linha[0] == '\n' || linha[0] == '\r') continue;
+        if (num == 1 && strncmp(linha, "estado,", 7) == 0) continue;
+        if (!lerLinhaCsv(linha, &c) || !adicionarCarta(b, &c)) { fclose(f); return num; }
+    }
+    fclose(f);
+    return 0;
+}
+
+int gerarCsv(const char *arquivo, size_t n) {
+    Carta c;
+    char area[TAM_TEXTO_FIXO], pib[TAM_TEXTO_FIXO];
+    FILE *f = fopen(arquivo, "w");
+    if (!f) return 0;
+    setvbuf(f, NULL, _IOFBF, 1 << 20);
+    fprintf(f, "estado,codigo,nome,populacao,area,pib,pontos\n");
+    for (size_t i = 0; i < n; i++) {
+        gerarCartaAleatoria(&c, i);
+        fprintf(f, "%c,%s,%s,%lu,%s,%s,%d\n", c.estado, c.codigo, c.nome, c.populacao,
+                formatarFixo(area, sizeof(area), c.area, CASAS_FIXO),
+                formatarFixo(pib, sizeof(pib), c.pib, CASAS_FIXO), c.pontosTuristicos);
+    }
+    return fclose(f) == 0;
+}
+
+int converterCsv(const char *entrada, const char *saida) {
+    Baralho b;
+    iniciarBaralho(&b);
+    uint64_t t0 = agoraNs();
+    long erro = carregarCsv(entrada, &b);
+    if (erro) {
+        if (erro < 0) fprintf(stderr, "Erro ao abrir %s\n", entrada);
+        else fprintf(stderr, "%s: linha %ld invalida\n", entrada, erro);
+        liberarBaralho(&b);
+        return 1;
+    }
+    double msLeitura = (agoraNs() - t0) / 1e6;
+    t0 = agoraNs();
+    int ok = gravarBaralhoBinario(saida, &b);
+    double msGravacao = (agoraNs() - t0) / 1e6;
+    if (ok) printf("%zu cartas: CSV lido em %.1f ms, binario gravado em %.1f ms (%s)\n",
+                   b.n, msLeitura, msGravacao, saida);
+    else fprintf(stderr, "Erro ao gravar %s\n", saida);
+    liberarBaralho(&b);
+    return ok ? 0 : 1;
+}
+
+/* Binario (pelo magico) via mmap; qualquer outra coisa e lida como CSV */
+int carregarBaralho(const char *arquivo, Baralho *b) {
+    char magico[8] = {0};
+    FILE *f = fopen(arquivo, "rb");
+    if (!f) { fprintf(stderr, "Erro ao abrir %s\n", arquivo); return 0; }
+    size_t lidos = fread(magico, 1, sizeof(magico), f);
+    fclose(f);
+    uint64_t t0 = agoraNs();
+    if (lidos == sizeof(magico) && memcmp(magico, MAGICO_BARALHO, sizeof(MAGICO_BARALHO)) == 0) {
+        if (!mapearBaralho(arquivo, b)) {
+            fprintf(stderr, "%s: arquivo binario invalido ou de outra versao\n", arquivo);
+            return 0;
+        }
+        /* toca uma vez cada pagina das colunas: custo real do carregamento */
+        volatile Fixo soma = 0;
+        for (int a = 0; a < NUM_ATRIBUTOS; a++)
+            for (size_t i = 0; i < b->n; i += 4096 / sizeof(Fixo)) soma += b->col[a][i];
+        printf("%zu cartas mapeadas de %s em %.2f ms\n", b->n, arquivo, (agoraNs() - t0) / 1e6);
+        return 1;
+    }
+    iniciarBaralho(b);
+    long erro = carregarCsv(arquivo, b);
+    if (erro) {
+        fprintf(stderr, "%s: linha %ld invalida\n", arquivo, erro);
+        liberarBaralho(b);
+        return 0;
+    }
+    printf("%zu cartas lidas do CSV %s em %.2f ms\n", b->n, arquivo, (agoraNs() - t0) / 1e6);
+    return 1;
+}
+
+/* ---------- Programa principal ---------- */
+
+int main(int argc, char *argv[]) {
+    INSTR_INICIAR();
+    size_t tamBench = 0, tamTorneio = 0, tamRanking = 0, consultas = 10000;
+    int torneio = 0, ranking = 0;
+    const char *arqSaida = NULL, *arqBaralho = NULL;
+    int numThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    Regra regra;
+    int comRegra = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) tamBench = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--torneio") == 0) {
+            torneio = 1;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) tamTorneio = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--ranking") == 0) {
+            ranking = 1;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) tamRanking = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--consultas") == 0 && i + 1 < argc) consultas = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--baralho") == 0 && i + 1 < argc) arqBaralho = argv[++i];
+        else if (strcmp(argv[i], "--converter") == 0 && i + 2 < argc) return converterCsv(argv[i + 1], argv[i + 2]);
+        else if (strcmp(argv[i], "--gerar-csv") == 0 && i + 2 < argc) {
+            if (gerarCsv(argv[i + 2], strtoull(argv[i + 1], NULL, 10))) return 0;
+            fprintf(stderr, "Erro ao gravar %s\n", argv[i + 2]);
+            return 1;
+        }
+        else if (strcmp(argv[i], "--saida") == 0 && i + 1 < argc) arqSaida = argv[++i];
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) numThreads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--regra") == 0 && i + 1 < argc) {
+            if (!lerRegra(argv[++i], &regra)) { fprintf(stderr, "Regra invalida: use %d pesos separados por virgula\n", NUM_ATRIBUTOS); return 1; }
+            comRegra = 1;
+        }
+    }
+    if (numThreads < 1) numThreads = 1;
+
+    selecionarKernels();
+    if (tamBench) return executarBench(tamBench);
+    if (arqBaralho || (torneio && tamTorneio) || (ranking && tamRanking)) {
+        Baralho b;
+        int r = 0;
+        iniciarBaralho(&b);
+        if (arqBaralho) {
+            if (!carregarBaralho(arqBaralho, &b)) return 1;
+        } else if (!gerarBaralho(&b, torneio ? tamTorneio : tamRanking)) {
+            fprintf(stderr, "Erro de alocacao\n");
+            return 1;
+        }
+        if (ranking) r = executarRanking(&b, consultas ? consultas : 1, numThreads);
+        if (torneio && !r) r = executarTorneio(&b, comRegra ? &regra : NULL, arqSaida, numThreads);
+        if (!ranking && !torneio && b.n) exibirCarta(&b, 0);
+        liberarBaralho(&b);
+        return r;
+    }
+
+    Baralho baralho;
+    Carta carta;
+    iniciarBaralho(&baralho);
+
+    /* Cadastro das Cartas */
+    for (int i = 1; i <= 2; i++) {
+        if (!cadastrarCarta(&carta, i) || !adicionarCarta(&baralho, &carta)) {
+            printf("Entrada invalida.\n");
+            liberarBaralho(&baralho);
+            return 1;
+        }
+    }
+    exibirCarta(&baralho, 0);
+    exibirCarta(&baralho, 1);
+
+    /* Comparacao de Cartas: carta 1 contra o baralho, e o inverso para
+       distinguir derrota de empate */
+    uint64_t vence1[NUM_ATRIBUTOS], vence2[NUM_ATRIBUTOS];
+    uint64_t *m1[NUM_ATRIBUTOS], *m2[NUM_ATRIBUTOS];
+    for (int a = 0; a < NUM_ATRIBUTOS; a++) { m1[a] = &vence1[a]; m2[a] = &vence2[a]; }
+    compararCartaBaralho(&baralho, 0, m1);
+    compararCartaBaralho(&baralho, 1, m2);
 
-// Desafio Super Trunfo - Países
-// Tema 2 - Comparação das Cartas
-// Este código inicial serve como base para o desenvolvimento do sistema de comparação de cartas de cidades. 
-// Siga os comentários para implementar cada parte do desafio.
-
-int main() {
-    // Definição das variáveis para armazenar as propriedades das cidades
-    // Você pode utilizar o código do primeiro desafio
-
-    
-    // Cadastro das Cartas:
-    // Implemente a lógica para solicitar ao usuário que insira os dados das cidades
-    // utilizando a função scanf para capturar as entradas.
-    // utilize o código do primeiro desafio
-
-    // Exemplo:
-    // printf("Digite o código da cidade: ");
-    // scanf("%s", codigo);
-    // 
-    // (Repita para cada propriedade)
-
-    // Comparação de Cartas:
-    // Desenvolva a lógica de comparação entre duas cartas.
-    // Utilize estruturas de decisão como if, if-else para comparar atributos como população, área, PIB, etc.
-
-    // Exemplo:
-    // if (populacaoA > populacaoB) {
-    //     printf("Cidade 1 tem maior população.\n");
-    // } else {
-    //     printf("Cidade 2 tem maior população.\n");
-    // }
-
-    // Exibição dos Resultados:
-    // Após realizar as comparações, exiba os resultados para o usuário.
-    // Certifique-se de que o sistema mostre claramente qual carta venceu e com base em qual atributo.
-
-    // Exemplo:
-    // printf("A cidade vencedora é: %s\n", cidadeVencedora);
+    /* Exibicao dos Resultados */
+    printf("\n=== Comparacao de cartas ===\n");
+    for (int a = 0; a < NUM_ATRIBUTOS; a++) {
+        int c1 = bitMascara(m1[a], 1), c2 = bitMascara(m2[a], 0);
+        printf("%-24s %s\n", nomesAtributos[a],
+               c1 ? "Carta 1 venceu (1)" : c2 ? "Carta 2 venceu (0)" : "Empate");
+    }
 
+    liberarBaralho(&baralho);
     return 0;
 }
@@ -0,0 +1,264 @@
+/*
+  render.h
+  Camada de saida compartilhada pelos jogos (somente cabecalho).
+
+  - BufferSaida: monta o texto de um quadro em um buffer reutilizavel e o
+    envia com um unico write(). bufEnviarMedido faz o mesmo contando
+    bytes, writes e tempo (MedidaSaida), para quem imprime tabelas que
+    rolam e nao usa Tela; porLinha=1 reproduz o printf linha a linha de
+    antes, como referencia.
+  - Tela: grade de caracteres largura x altura. A cada quadro compara com
+    o quadro anterior e emite apenas as celulas que mudaram (posicionando
+    o cursor com sequencias ANSI). Conta bytes escritos e tempo por quadro.
+
+  O diff supoe que a tela nao rolou desde o quadro anterior. Por isso a
+  entrada fica logo abaixo do quadro: telaPrompt escreve sempre na linha
+  altura+1 e o Enter desce no maximo para altura+2. Se o terminal tiver
+  menos linhas que isso, a entrada rola a tela e cada quadro e redesenhado
+  por inteiro.
+*/
+
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+typedef struct {
+    char *dados;
+    size_t tam, cap;
+} BufferSaida;
+
+static inline void bufIniciar(BufferSaida *b) {
+    b->dados = NULL;
+    b->tam = b->cap = 0;
+}
+
+static inline int bufReservar(BufferSaida *b, size_t extra) {
+    if (b->tam + extra <= b->cap) return 1;
+    size_t nova = b->cap ? b->cap : 1024;
+    while (nova < b->tam + extra) nova *= 2;
+    char *p = realloc(b->dados, nova);
+    if (!p) return 0;
+    b->dados = p;
+    b->cap = nova;
+    return 1;
+}
+
+static inline void bufAnexar(BufferSaida *b, const char *s, size_t n) {
+    if (!bufReservar(b, n)) return;
+    memcpy(b->dados + b->tam, s, n);
+    b->tam += n;
+}
+
+static inline void bufPrintf(BufferSaida *b, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if (n <= 0 || !bufReservar(b, (size_t)n + 1)) return;
+    va_start(ap, fmt);
+    vsnprintf(b->dados + b->tam, (size_t)n + 1, fmt, ap);
+    va_end(ap);
+    b->tam += (size_t)n;
+}
+
+/* write() de n bytes, repetindo em escrita parcial; soma as chamadas em
+   *writes (se nao for NULL) */
+static inline size_t bufEscrever(const char *s, size_t n, unsigned long long *writes) {
+    size_t enviado = 0;
+    while (enviado < n) {
+        ssize_t w = write(STDOUT_FILENO, s + enviado, n - enviado);
+        if (writes) (*writes)++;
+        if (w <= 0) break;
+        enviado += (size_t)w;
+    }
+    return enviado;
+}
+
+/* Envia o buffer inteiro com write() e o esvazia (sem liberar memoria).
+   O stdout e descarregado antes para manter a ordem com os printf. */
+static inline size_t bufDescarregar(BufferSaida *b) {
+    fflush(stdout);
+    size_t enviado = bufEscrever(b->dados, b->tam, NULL);
+    b->tam = 0;
+    return enviado;
+}
+
+static inline void bufLiberar(BufferSaida *b) {
+    free(b->dados);
+    bufIniciar(b);
+}
+
+/* Trechos inalterados menores que isto sao reenviados em vez de pagar
+   outra sequencia de posicionamento do cursor (~8 bytes). */
+#define TELA_EMENDA 8
+
+typedef struct {
+    int largura, altura;
+    char *atual, *anterior;
+    int primeiro;
+    int diferencial;            /* 0 = redesenha o quadro inteiro sempre */
+    BufferSaida saida;
+    unsigned long long quadros, bytes, nsTotal;
+} Tela;
+
+static inline int telaIniciar(Tela *t, int largura, int altura, int diferencial) {
+    size_t n = (size_t)largura * (size_t)altura;
+    t->largura = largura;
+    t->altura = altura;
+    t->atual = malloc(n);
+    t->anterior = malloc(n);
+    t->primeiro = 1;
+    t->diferencial = diferencial;
+    t->quadros = t->bytes = t->nsTotal = 0;
+    bufIniciar(&t->saida);
+    if (!t->atual || !t->anterior) return 0;
+    memset(t->atual, ' ', n);
+    memset(t->anterior, ' ', n);
+    return 1;
+}
+
+static inline void telaLimpar(Tela *t) {
+    memset(t->atual, ' ', (size_t)t->largura * (size_t)t->altura);
+}
+
+/* Escreve texto formatado a partir de (x, y), cortando na borda */
+static inline void telaEscrever(Tela *t, int x, int y, const char *fmt, ...) {
+    char tmp[512];
+    if (y < 0 || y >= t->altura || x >= t->largura) return;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+    va_end(ap);
+    if (n <= 0) return;
+    if (n > (int)sizeof(tmp) - 1) n = (int)sizeof(tmp) - 1;
+    if (n > t->largura - x) n = t->largura - x;
+    memcpy(t->atual + (size_t)y * t->largura + x, tmp, (size_t)n);
+}
+
+static inline unsigned long long telaAgoraNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec;
+}
+
+/* Linhas do terminal em stdout (0 se nao for terminal) */
+static inline int telaLinhasTerminal(void) {
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) != 0) return 0;
+    return ws.ws_row;
+}
+
+/* Emite o quadro: so os trechos alterados (ou tudo, no modo completo),
+   depois deixa o cursor na linha abaixo do quadro limpando o resto da
+   tela (apaga o eco da entrada anterior). Um unico write por quadro. */
+static inline void telaApresentar(Tela *t) {
+    unsigned long long inicio = telaAgoraNs();
+    BufferSaida *b = &t->saida;
+    int linhas = telaLinhasTerminal();
+    /* terminal baixo: a entrada pode ter rolado a tela e o quadro
+       anterior nao corresponde mais ao que esta exibido */
+    if (linhas > 0 && linhas < t->altura + 2) t->primeiro = 1;
+    int tudo = !t->diferencial;
+    /* primeiro quadro: limpa a tela e compara contra o quadro em branco */
+    if (t->primeiro) {
+        bufAnexar(b, "\x1b[H\x1b[2J", 7);
+        memset(t->anterior, ' ', (size_t)t->largura * (size_t)t->altura);
+    }
+    for (int y = 0; y < t->altura; y++) {
+        const char *at = t->atual + (size_t)y * t->largura;
+        const char *ant = t->anterior + (size_t)y * t->largura;
+        int x = 0;
+        while (x < t->largura) {
+            if (!tudo && at[x] == ant[x]) { x++; continue; }
+            int fim = x + 1, iguais = 0;
+            while (fim + iguais < t->largura) {
+                if (tudo || at[fim + iguais] != ant[fim + iguais]) { fim += iguais + 1; iguais = 0; }
+                else if (++iguais > TELA_EMENDA) break;
+            }
+            bufPrintf(b, "\x1b[%d;%dH", y + 1, x + 1);
+            bufAnexar(b, at + x, (size_t)(fim - x));
+            x = fim;
+        }
+    }
+    bufPrintf(b, "\x1b[%d;1H\x1b[J", t->altura + 1);
+    t->bytes += bufDescarregar(b);
+    char *aux = t->anterior;
+    t->anterior = t->atual;
+    t->atual = aux;
+    t->primeiro = 0;
+    t->quadros++;
+    t->nsTotal += telaAgoraNs() - inicio;
+}
+
+/* Pergunta ao jogador na linha logo abaixo do quadro, apagando a resposta
+   anterior: varias perguntas seguidas nao descem a tela */
+static inline void telaPrompt(Tela *t, const char *fmt, ...) {
+    char tmp[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+    if (n > (int)sizeof(tmp) - 1) n = (int)sizeof(tmp) - 1;
+    bufPrintf(&t->saida, "\x1b[%d;1H\x1b[J", t->altura + 1);
+    bufAnexar(&t->saida, tmp, (size_t)n);
+    t->bytes += bufDescarregar(&t->saida);
+}
+
+static inline void telaEstatisticas(const Tela *t, FILE *out) {
+    if (!t->quadros) return;
+    fprintf(out, "Render (%s): %llu quadros, %llu bytes (%.1f/quadro), %.2f us/quadro\n",
+            t->diferencial ? "diferencial" : "completo", t->quadros, t->bytes,
+            (double)t->bytes / t->quadros, t->nsTotal / 1e3 / t->quadros);
+}
+
+/* Emissoes medidas fora da Tela (tabelas que rolam) */
+typedef struct {
+    unsigned long long quadros, bytes, writes, nsTotal;
+} MedidaSaida;
+
+/* Envia e esvazia o buffer somando bytes, writes e tempo em *m. Com
+   porLinha, um write por linha: o que o printf de cada linha fazia num
+   terminal (buffer de linha), para medir o antes. */
+static inline void bufEnviarMedido(BufferSaida *b, int porLinha, MedidaSaida *m) {
+    unsigned long long inicio = telaAgoraNs();
+    size_t enviado = 0;
+    fflush(stdout);
+    if (!porLinha) {
+        enviado = bufEscrever(b->dados, b->tam, &m->writes);
+    } else {
+        size_t ini = 0;
+        for (size_t i = 0; i < b->tam; i++) {
+            if (b->dados[i] != '\n' && i + 1 < b->tam) continue;
+            enviado += bufEscrever(b->dados + ini, i + 1 - ini, &m->writes);
+            ini = i + 1;
+        }
+    }
+    b->tam = 0;
+    m->bytes += enviado;
+    m->quadros++;
+    m->nsTotal += telaAgoraNs() - inicio;
+}
+
+static inline void medidaEstatisticas(const MedidaSaida *m, const char *modo, FILE *out) {
+    if (!m->quadros) return;
+    fprintf(out, "Saida (%s): %llu tabelas, %llu bytes (%.1f/tabela), %.1f writes/tabela, %.2f us/tabela\n",
+            modo, m->quadros, m->bytes, (double)m->bytes / m->quadros,
+            (double)m->writes / m->quadros, m->nsTotal / 1e3 / m->quadros);
+}
+
+static inline void telaLiberar(Tela *t) {
+    free(t->atual);
+    free(t->anterior);
+    t->atual = t->anterior = NULL;
+    bufLiberar(&t->saida);
+}
+
+#endif /* RENDER_H */
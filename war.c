@@ -1,7 +1,10 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include "render.h"
+#include "instrumentacao.h"
 
 #define TAM_MAPA 6
 #define MAX_MISSAO_LEN 100
@@ -13,6 +16,12 @@ typedef struct {
     int tropas;
 } Territorio;
 
+/* Saída das tabelas: buffer + um write (padrão) ou um write por linha
+   (--saida-direta, como o printf original) para comparar. As medidas
+   saem em stderr ao terminar. */
+static int saidaDireta = 0;
+static MedidaSaida medidaMapa;
+
 /* Prototypes das funções (modularização) */
 void atribuirMissao(char* destino, char* missoes[], int totalMissoes, const char* corJogador);
 int verificarMissao(const char* missao, const char* corJogador, Territorio* mapa, int tamanho);
@@ -39,6 +48,7 @@ void atribuirMissao(char* destino, char* missoes[], int totalMissoes, const char
 /* Verifica se a missão foi cumprida.
    Interpreta missões baseando-se em prefixos "M1:", "M2:", etc. */
 int verificarMissao(const char* missao, const char* corJogador, Territorio* mapa, int tamanho) {
+    INSTR_ESCOPO(verificarMissao);
     if (!missao || !corJogador || !mapa) return 0;
 
     /* M1: Conquistar 3 territórios seguidos (3 vizinhos no vetor) */
@@ -100,6 +110,7 @@ void exibirMissao(const char* missao) {
 
 /* Simula um ataque entre dois territórios */
 void atacar(Territorio* atacante, Territorio* defensor) {
+    INSTR_ESCOPO(atacar);
     if (!atacante || !defensor) return;
 
     int dadoA = (rand() % 6) + 1;
@@ -125,15 +136,19 @@ void atacar(Territorio* atacante, Territorio* defensor) {
     if (defensor->tropas < 0) defensor->tropas = 0;
 }
 
-/* Mostra o mapa (lista de territórios) */
+/* Mostra o mapa (lista de territórios).
+   A tabela é montada em um buffer reutilizado e enviada com um único write
+   (um por linha com --saida-direta). */
 void exibirMapa(Territorio* mapa, int tamanho) {
-    printf("\nMAPA ATUAL:\n");
-    printf("Idx  Nome   Cor    Tropas\n");
-    printf("--------------------------------\n");
+    static BufferSaida saida;
+    bufPrintf(&saida, "\nMAPA ATUAL:\n");
+    bufPrintf(&saida, "Idx  Nome   Cor    Tropas\n");
+    bufPrintf(&saida, "--------------------------------\n");
     for (int i = 0; i < tamanho; ++i) {
-        printf("%2d   %-5s  %-5s   %2d\n", i, mapa[i].nome, mapa[i].cor, mapa[i].tropas);
+        bufPrintf(&saida, "%2d   %-5s  %-5s   %2d\n", i, mapa[i].nome, mapa[i].cor, mapa[i].tropas);
     }
-    printf("\n");
+    bufPrintf(&saida, "\n");
+    bufEnviarMedido(&saida, saidaDireta, &medidaMapa);
 }
 
 /* Libera memória alocada dinamicamente */
@@ -153,7 +168,10 @@ void liberarMemoria(Territorio** mapa, char** missao1, char** missao2) {
 }
 
 /* Função principal: fluxo do jogo */
-int main(void) {
+int main(int argc, char *argv[]) {
+    INSTR_INICIAR();
+    for (int i = 1; i < argc; ++i)
+        if (strcmp(argv[i], "--saida-direta") == 0) saidaDireta = 1;
     srand((unsigned)time(NULL));
 
     /* Vetor de missões */
@@ -282,6 +300,7 @@ int main(void) {
         vez = (vez == 1) ? 2 : 1; /* Alterna vez */
     }
 
+    medidaEstatisticas(&medidaMapa, saidaDireta ? "direta" : "buffer", stderr);
     liberarMemoria(&mapa, &missaoJogador1, &missaoJogador2);
     return 0;
 }
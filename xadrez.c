@@ -1,133 +1,1239 @@
-    #include <stdio.h>
-    #include <stdlib.h>
-    #include <time.h>
-    #define TAM_FILA 5
-    #define TAM_PILHA 3
+/*
+  xadrez.c
+  Tetris Stack: fila de pecas futuras e pilha de reserva.
 
-    typedef struct {
-        char nome;
-        int id;
-    } Peca;
+  Compilar:
+    gcc -std=c11 -Wall -Wextra -O2 -pthread -o xadrez xadrez.c
 
-    typedef struct {
-        Peca itens[TAM_FILA];
-        int inicio, fim, qtd;
-    } Fila;
+  Uso:
+    ./xadrez [semente] [--feixe N] [--orcamento-ms M] [--threads T]
+             [--fila N] [--pilha N] [--troca K] [--historico N]
+    (mesma semente -> mesma sequencia de pecas)
 
-    typedef struct {
-        Peca itens[TAM_PILHA];
-        int topo;
-    } Pilha;
+  Tela: por padrao so as celulas alteradas sao reenviadas a cada quadro;
+  --render-completo redesenha tudo (para comparar bytes/tempo por quadro,
+  impressos em stderr ao sair).
 
-    char tipos[] = {'I','O','T','L'};
-    int contadorId = 1;
+  Modo sem interface (regressao/perfil):
+    ./xadrez semente --headless --acoes N [--gravar acoes.txt]
+    ./xadrez semente --headless --replay acoes.txt
+    ./xadrez semente --headless --acoes N --desfazer
+  Executa uma sequencia de acoes 1..5 (sorteada ou gravada) sem imprimir
+  nada por operacao e mostra checksum do estado final e operacoes/s.
+  Com --desfazer as acoes 6 (desfazer) e 7 (refazer) entram no sorteio;
+  cada acao que move o diario e revertida e reaplicada na hora conferindo
+  o checksum de antes e de depois (o tempo inclui essa conferencia) e, ao
+  final, todo o historico retido e desfeito e refeito. Divergencia sai
+  com codigo 1.
 
-    Peca gerarPeca() {
-        Peca nova;
-        nova.nome = tipos[rand() % 4];
-        nova.id = contadorId++;
-        return nova;
+  Benchmark das estruturas (estruturas.h) em varias capacidades:
+    ./xadrez --bench-estruturas
+
+  Distribuicao (qui-quadrado por posicao) e vazao do gerador 7-bag:
+    ./xadrez [semente] --conferir-gerador
+
+  Latencias por operacao (enfileirar, desenfileirar, busca da IA):
+  compile com -DINSTRUMENTAR; o relatorio sai em stderr ao terminar ou
+  com kill -USR1 (ver instrumentacao.h).
+*/
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "render.h"
+#include "estruturas.h"
+#include "instrumentacao.h"
+#define TAM_FILA 5
+#define TAM_PILHA 3
+#define TAM_TROCA 3
+#define HISTORICO_PADRAO 4096
+#define MAX_OPS_ACAO 6      /* jogada automatica: troca multipla, troca, desenfileirar,
+                               soltar, gerar, enfileirar */
+#define NUM_TIPOS 7
+#define LARGURA_TAB 10
+#define ALTURA_TAB 20
+#define ALTURA_TOTAL (ALTURA_TAB + 4)   /* 4 linhas ocultas para nascer a peca */
+#define LINHA_CHEIA ((uint16_t)((1u << LARGURA_TAB) - 1))
+#define MAX_FILHOS (2 * 4 * LARGURA_TAB)   /* (fila|reserva) x rotacoes x colunas */
+#define TELA_LARGURA 80
+#define TELA_ALTURA (ALTURA_TAB + 2)   /* tabuleiro + borda + mensagem; menu ao lado */
+#define FEIXE_PADRAO 128
+#define ORCAMENTO_PADRAO_MS 5
+
+typedef struct {
+    char nome;
+    int id;
+} Peca;
+
+/* Fila e pilha crescem sob demanda; os limites do jogo ficam em
+   tamFila/tamPilha (configuraveis pela linha de comando). */
+DEFINIR_DEQUE_DINAMICO(Fila, Peca)
+DEFINIR_PILHA_DINAMICA(Pilha, Peca)
+DEFINIR_TROCA_DEQUE_PILHA(trocarBloco, Fila, Pilha, Peca)
+
+static int tamFila = TAM_FILA, tamPilha = TAM_PILHA, qtdTroca = TAM_TROCA;
+
+/* Tabuleiro em bitboard: cada linha e uma palavra, bit c = coluna c,
+   linha 0 = fundo. Colisao vira AND, linha cheia vira comparacao. */
+typedef struct {
+    uint16_t linhas[ALTURA_TOTAL];
+    int linhasLimpas;
+    int fimDeJogo;
+} Tabuleiro;
+
+/* Gerador de pecas por instancia: PRNG xorshift64* proprio + saco de 7
+   (cada saco contem os 7 tetrominos embaralhados). Sem estado global,
+   entao varios jogos podem coexistir e a sequencia e reproduzivel. */
+typedef struct {
+    uint64_t estado;
+    char saco[NUM_TIPOS];
+    int posSaco;
+    int contadorId;
+} Gerador;
+
+/* Desliga as mensagens das operacoes (jogadas automaticas em lote) */
+static int silencioso = 0;
+static char ultimaMensagem[TELA_LARGURA];
+
+/* Mensagem da ultima operacao, exibida na linha de status do quadro */
+static void mensagem(const char *fmt, ...) {
+    if (silencioso) return;
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(ultimaMensagem, sizeof(ultimaMensagem), fmt, ap);
+    va_end(ap);
+}
+
+static const char tipos[NUM_TIPOS] = {'I','O','T','L','J','S','Z'};
+
+static inline uint64_t proximoAleatorio(uint64_t *s) {
+    uint64_t x = *s;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *s = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+void inicializarGerador(Gerador *g, uint64_t semente) {
+    /* splitmix64 espalha sementes pequenas/parecidas; xorshift nao aceita 0 */
+    uint64_t z = semente + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    g->estado = z ? z : 1;
+    g->posSaco = NUM_TIPOS; /* forca reabastecer na primeira peca */
+    g->contadorId = 1;
+}
+
+/* Reabastece o saco inteiro de uma vez (Fisher-Yates). Cada sorteio de 64
+   bits rende dois indices de 32 bits, reduzidos por multiplicacao: sorteia
+   na 1a, 3a e 5a troca e usa a metade alta na troca seguinte. */
+static void reabastecerSaco(Gerador *g) {
+    for (int i = 0; i < NUM_TIPOS; i++) g->saco[i] = tipos[i];
+    uint64_t r = 0;
+    for (int i = NUM_TIPOS - 1; i > 0; i--) {
+        if ((NUM_TIPOS - 1 - i) % 2 == 0) r = proximoAleatorio(&g->estado);
+        else r >>= 32;
+        int j = (int)(((r & 0xFFFFFFFFu) * (uint64_t)(i + 1)) >> 32);
+        char aux = g->saco[i];
+        g->saco[i] = g->saco[j];
+        g->saco[j] = aux;
+    }
+    g->posSaco = 0;
+}
+
+Peca gerarPeca(Gerador *g) {
+    if (g->posSaco == NUM_TIPOS) reabastecerSaco(g);
+    Peca nova;
+    nova.nome = g->saco[g->posSaco++];
+    nova.id = g->contadorId++;
+    return nova;
+}
+
+static volatile unsigned sumidouroPecas;
+
+/* Confere a distribuicao do saco: em cada posicao, cada tipo deve sair em
+   ~1/7 dos sacos. Qui-quadrado com 6*7 = 42 graus de liberdade; acima de
+   ~77 (p < 0,001) o embaralhamento esta viciado. Depois mede a vazao
+   (pecas/ms) gerando numPecas pecas seguidas. */
+int conferirGerador(uint64_t semente, long long numSacos, long long numPecas) {
+    long long contagem[NUM_TIPOS][NUM_TIPOS] = {{0}};
+    Gerador g;
+    inicializarGerador(&g, semente);
+    for (long long s = 0; s < numSacos; s++)
+        for (int pos = 0; pos < NUM_TIPOS; pos++) {
+            char nome = gerarPeca(&g).nome;
+            int t = 0;
+            while (tipos[t] != nome) t++;
+            contagem[pos][t]++;
+        }
+    double esperado = (double)numSacos / NUM_TIPOS, qui = 0, pior = 0;
+    printf("Posicao   I      O      T      L      J      S      Z   (%% dos sacos)\n");
+    for (int pos = 0; pos < NUM_TIPOS; pos++) {
+        printf("%4d  ", pos);
+        for (int t = 0; t < NUM_TIPOS; t++) {
+            double d = contagem[pos][t] - esperado;
+            qui += d * d / esperado;
+            if ((d < 0 ? -d : d) / esperado > pior) pior = (d < 0 ? -d : d) / esperado;
+            printf(" %6.2f", 100.0 * contagem[pos][t] / numSacos);
+        }
+        printf("\n");
+    }
+    int ok = qui < 77.0;
+    printf("%lld sacos, qui-quadrado %.1f (42 g.l.), maior desvio %.2f%%: %s\n",
+           numSacos, qui, 100.0 * pior, ok ? "uniforme" : "VICIADO");
+
+    unsigned soma = 0;
+    clock_t inicio = clock();
+    for (long long i = 0; i < numPecas; i++) soma += (unsigned char)gerarPeca(&g).nome;
+    double ms = (double)(clock() - inicio) * 1000.0 / CLOCKS_PER_SEC;
+    sumidouroPecas = soma;
+    printf("%lld pecas em %.1f ms: %.2f milhoes de pecas/ms\n",
+           numPecas, ms, ms > 0 ? numPecas / ms / 1e6 : 0.0);
+    return ok ? 0 : 1;
+}
+
+/* Mascaras de cada tetromino por rotacao: 4 linhas de baixo para cima,
+   alinhadas a coluna 0. Mesma ordem de tipos[]. */
+static const uint16_t formas[NUM_TIPOS][4][4] = {
+    /* I */ {{0xF,0,0,0}, {1,1,1,1}, {0xF,0,0,0}, {1,1,1,1}},
+    /* O */ {{3,3,0,0}, {3,3,0,0}, {3,3,0,0}, {3,3,0,0}},
+    /* T */ {{7,2,0,0}, {1,3,1,0}, {2,7,0,0}, {2,3,2,0}},
+    /* L */ {{7,4,0,0}, {3,1,1,0}, {1,7,0,0}, {2,2,3,0}},
+    /* J */ {{7,1,0,0}, {1,1,3,0}, {4,7,0,0}, {3,2,2,0}},
+    /* S */ {{3,6,0,0}, {2,3,1,0}, {3,6,0,0}, {2,3,1,0}},
+    /* Z */ {{6,3,0,0}, {1,3,2,0}, {6,3,0,0}, {1,3,2,0}},
+};
+
+int indiceTipo(char nome) {
+    for (int i = 0; i < NUM_TIPOS; i++) if (tipos[i] == nome) return i;
+    return -1;
+}
+
+static inline const uint16_t *formaPeca(char nome, int rot) {
+    return formas[indiceTipo(nome)][rot & 3];
+}
+
+static inline int larguraForma(const uint16_t *forma) {
+    unsigned o = forma[0] | forma[1] | forma[2] | forma[3];
+    return 32 - __builtin_clz(o);
+}
+
+void inicializarTabuleiro(Tabuleiro *t) {
+    memset(t->linhas, 0, sizeof(t->linhas));
+    t->linhasLimpas = 0;
+    t->fimDeJogo = 0;
+}
+
+int posicaoValida(char nome, int rot, int col) {
+    if (indiceTipo(nome) < 0) return 0;
+    return col >= 0 && col + larguraForma(formaPeca(nome, rot)) <= LARGURA_TAB;
+}
+
+/* Colisao da forma com a base em (col, y): um AND por linha da peca */
+static inline int colide(const Tabuleiro *t, const uint16_t *forma, int col, int y) {
+    for (int r = 0; r < 4 && forma[r]; r++) {
+        if (y + r < 0 || y + r >= ALTURA_TOTAL) return 1;
+        if (t->linhas[y + r] & (uint16_t)(forma[r] << col)) return 1;
+    }
+    return 0;
+}
+
+/* Remove linhas cheias entre y e y+3 (de cima para baixo) deslocando o
+   bloco de cima com memmove. Retorna quantas foram removidas e marca em
+   *mascara quais (bit b = linha y+b), para o diario poder recoloca-las. */
+static int limparLinhas(Tabuleiro *t, int y, unsigned *mascara) {
+    int removidas = 0;
+    *mascara = 0;
+    for (int r = y + 3; r >= y; r--) {
+        if (r < 0 || r >= ALTURA_TOTAL || t->linhas[r] != LINHA_CHEIA) continue;
+        memmove(&t->linhas[r], &t->linhas[r + 1], (size_t)(ALTURA_TOTAL - 1 - r) * sizeof(uint16_t));
+        t->linhas[ALTURA_TOTAL - 1] = 0;
+        *mascara |= 1u << (r - y);
+        removidas++;
+    }
+    return removidas;
+}
+
+/* Queda livre da peca na coluna/rotacao dadas. Retorna linhas removidas,
+   ou -1 se a posicao for invalida (tabuleiro intacto). Se yFinal/mascara
+   nao forem NULL recebem a linha onde a peca parou (-1 se nao coube) e as
+   linhas removidas. */
+int soltarPecaDetalhada(Tabuleiro *t, char nome, int rot, int col, int *yFinal, unsigned *mascara) {
+    if (t->fimDeJogo || !posicaoValida(nome, rot, col)) return -1;
+    const uint16_t *forma = formaPeca(nome, rot);
+    unsigned removidasMascara = 0;
+    int y = ALTURA_TAB;
+    if (colide(t, forma, col, y)) {
+        t->fimDeJogo = 1;
+        if (yFinal) *yFinal = -1;
+        if (mascara) *mascara = 0;
+        return 0;
+    }
+    while (y > 0 && !colide(t, forma, col, y - 1)) y--;
+    for (int r = 0; r < 4 && forma[r]; r++) t->linhas[y + r] |= (uint16_t)(forma[r] << col);
+    int removidas = limparLinhas(t, y, &removidasMascara);
+    t->linhasLimpas += removidas;
+    for (int r = ALTURA_TAB; r < ALTURA_TOTAL; r++)
+        if (t->linhas[r]) { t->fimDeJogo = 1; break; }
+    if (yFinal) *yFinal = y;
+    if (mascara) *mascara = removidasMascara;
+    return removidas;
+}
+
+int soltarPeca(Tabuleiro *t, char nome, int rot, int col) {
+    return soltarPecaDetalhada(t, nome, rot, col, NULL, NULL);
+}
+
+/* ---------- Diario de operacoes (desfazer/refazer) ---------- */
+
+/* Cada mutacao guarda so o necessario para inverte-la: a peca movida, o
+   tamanho da troca (troca e sua propria inversa), a queda (linha final e
+   linhas removidas) ou o gerador anterior. O anel tem capacidade fixa;
+   quando enche, a acao mais antiga e descartada inteira. */
+enum { OP_ENFILEIRAR, OP_DESENFILEIRAR, OP_EMPILHAR, OP_DESEMPILHAR, OP_TROCA, OP_SOLTAR, OP_GERAR };
+
+typedef struct {
+    unsigned char tipo;
+    unsigned char inicioAcao;   /* primeira operacao de uma acao do jogador */
+    union {
+        Peca peca;
+        int k;
+        struct { char nome; signed char rot, col, y; unsigned char removidas; } queda;
+        Gerador gerador;
+    } u;
+} OperacaoDiario;
+
+typedef struct {
+    OperacaoDiario *ops;
+    uint64_t mascara;
+    uint64_t base, cursor, topo;   /* [base, cursor) desfazer, [cursor, topo) refazer */
+    uint64_t inicioAtual;          /* primeira operacao da acao em curso */
+    int novaAcao;
+    int descartando;               /* acao em curso nao coube: nao registra */
+} Diario;
+
+/* Diario que as operacoes do jogo alimentam (NULL = sem historico) */
+static Diario *diarioAtivo = NULL;
+
+/* A capacidade nunca fica abaixo da maior acao, senao o anel comeca a
+   descartar a propria acao em curso e desfazer para no meio dela */
+int criarDiario(Diario *d, int capacidade) {
+    uint64_t cap = 1;
+    while (cap < (uint64_t)(capacidade > MAX_OPS_ACAO ? capacidade : MAX_OPS_ACAO)) cap <<= 1;
+    d->ops = malloc(cap * sizeof(OperacaoDiario));
+    d->mascara = cap - 1;
+    d->base = d->cursor = d->topo = d->inicioAtual = 0;
+    d->novaAcao = 1;
+    d->descartando = 0;
+    return d->ops != NULL;
+}
+
+void liberarDiario(Diario *d) { free(d->ops); d->ops = NULL; }
+
+void limparDiario(Diario *d) {
+    d->base = d->cursor = d->topo = d->inicioAtual = 0;
+    d->novaAcao = 1;
+    d->descartando = 0;
+}
+
+/* Marca o inicio de uma acao do jogador: desfazer/refazer andam por acao */
+void iniciarAcao(void) { if (diarioAtivo) diarioAtivo->novaAcao = 1; }
+
+static void registrar(OperacaoDiario op) {
+    Diario *d = diarioAtivo;
+    if (!d) return;
+    if (d->novaAcao) {
+        d->inicioAtual = d->cursor;
+        d->descartando = 0;
+    } else if (d->descartando) {
+        return;
+    }
+    op.inicioAcao = (unsigned char)d->novaAcao;
+    d->novaAcao = 0;
+    if (d->cursor - d->base > d->mascara) {
+        /* a acao em curso ocupa o anel inteiro: descarta o historico todo
+           (inclusive ela) em vez de guardar uma acao pela metade */
+        if (d->base == d->inicioAtual) {
+            d->base = d->topo = d->cursor;
+            d->descartando = 1;
+            return;
+        }
+        d->base++;
+        while (d->base < d->cursor && !d->ops[d->base & d->mascara].inicioAcao) d->base++;
+    }
+    d->ops[d->cursor & d->mascara] = op;
+    d->topo = ++d->cursor;
+}
+
+static void registrarPeca(int tipo, Peca x) {
+    OperacaoDiario op = {0};
+    op.tipo = (unsigned char)tipo;
+    op.u.peca = x;
+    registrar(op);
+}
+
+Peca gerarPecaRegistrada(Gerador *g) {
+    OperacaoDiario op = {0};
+    op.tipo = OP_GERAR;
+    if (diarioAtivo) op.u.gerador = *g;
+    Peca nova = gerarPeca(g);
+    registrar(op);
+    return nova;
+}
+
+/* Recoloca as linhas removidas (de baixo para cima, inverso da remocao)
+   e apaga a peca com AND da mascara invertida */
+static void desfazerQueda(Tabuleiro *t, const OperacaoDiario *op) {
+    t->fimDeJogo = 0;
+    if (op->u.queda.y < 0) return;
+    int y = op->u.queda.y, col = op->u.queda.col;
+    for (int b = 0; b < 4; b++) {
+        if (!(op->u.queda.removidas >> b & 1)) continue;
+        memmove(&t->linhas[y + b + 1], &t->linhas[y + b], (size_t)(ALTURA_TOTAL - 1 - (y + b)) * sizeof(uint16_t));
+        t->linhas[y + b] = LINHA_CHEIA;
+        t->linhasLimpas--;
+    }
+    const uint16_t *forma = formaPeca(op->u.queda.nome, op->u.queda.rot);
+    for (int r = 0; r < 4 && forma[r]; r++) t->linhas[y + r] &= (uint16_t)~(forma[r] << col);
+}
+
+static void trocarGerador(Gerador *g, OperacaoDiario *op) {
+    Gerador aux = *g;
+    *g = op->u.gerador;
+    op->u.gerador = aux;
+}
+
+static void aplicarOperacao(OperacaoDiario *op, int desfazendo, Fila *f, Pilha *p, Tabuleiro *t, Gerador *g) {
+    switch (op->tipo) {
+        case OP_ENFILEIRAR:
+            if (desfazendo) Fila_removerFim(f, NULL); else Fila_inserirFim(f, op->u.peca);
+            break;
+        case OP_DESENFILEIRAR:
+            if (desfazendo) Fila_inserirInicio(f, op->u.peca); else Fila_removerInicio(f, NULL);
+            break;
+        case OP_EMPILHAR:
+            if (desfazendo) Pilha_desempilhar(p, NULL); else Pilha_empilhar(p, op->u.peca);
+            break;
+        case OP_DESEMPILHAR:
+            if (desfazendo) Pilha_empilhar(p, op->u.peca); else Pilha_desempilhar(p, NULL);
+            break;
+        case OP_TROCA:
+            trocarBloco(f, p, op->u.k);
+            break;
+        case OP_SOLTAR:
+            if (desfazendo) desfazerQueda(t, op);
+            else soltarPeca(t, op->u.queda.nome, op->u.queda.rot, op->u.queda.col);
+            break;
+        case OP_GERAR:
+            trocarGerador(g, op);
+            break;
     }
+}
 
-    void inicializarFila(Fila *f) { f->inicio = 0; f->fim = -1; f->qtd = 0; }
-    int filaCheia(Fila *f) { return f->qtd == TAM_FILA; }
-    int filaVazia(Fila *f) { return f->qtd == 0; }
+/* Desfaz a ultima acao inteira. Retorna 0 se nao ha historico. */
+int desfazer(Diario *d, Fila *f, Pilha *p, Tabuleiro *t, Gerador *g) {
+    if (d->cursor == d->base) return 0;
+    OperacaoDiario *op;
+    do {
+        op = &d->ops[--d->cursor & d->mascara];
+        aplicarOperacao(op, 1, f, p, t, g);
+    } while (!op->inicioAcao && d->cursor > d->base);
+    return 1;
+}
+
+int refazer(Diario *d, Fila *f, Pilha *p, Tabuleiro *t, Gerador *g) {
+    if (d->cursor == d->topo) return 0;
+    do {
+        aplicarOperacao(&d->ops[d->cursor++ & d->mascara], 0, f, p, t, g);
+    } while (d->cursor < d->topo && !d->ops[d->cursor & d->mascara].inicioAcao);
+    return 1;
+}
+
+void inicializarFila(Fila *f) { Fila_iniciar(f); Fila_garantir(f, tamFila); }
+int filaCheia(Fila *f) { return f->qtd >= tamFila; }
+int filaVazia(Fila *f) { return f->qtd == 0; }
 
 void enfileirar(Fila *f, Peca p) {
+    INSTR_ESCOPO(enfileirar);
     if(filaCheia(f)) return;
-    f->fim = (f->fim + 1) % TAM_FILA;
-    f->itens[f->fim] = p;
-    f->qtd++;
+    if(Fila_inserirFim(f, p)) registrarPeca(OP_ENFILEIRAR, p);
 }
 
 Peca desenfileirar(Fila *f) {
+    INSTR_ESCOPO(desenfileirar);
     Peca removido = {'-', -1};
-    if(filaVazia(f)) return removido;
-    removido = f->itens[f->inicio];
-    f->inicio = (f->inicio + 1) % TAM_FILA;
-    f->qtd--;
+    if(Fila_removerInicio(f, &removido)) registrarPeca(OP_DESENFILEIRAR, removido);
     return removido;
 }
 
-void inicializarPilha(Pilha *p) { p->topo = -1; }
-int pilhaCheia(Pilha *p) { return p->topo == TAM_PILHA-1; }
-int pilhaVazia(Pilha *p) { return p->topo == -1; }
+void inicializarPilha(Pilha *p) { Pilha_iniciar(p); Pilha_garantir(p, tamPilha); }
+int pilhaCheia(Pilha *p) { return p->qtd >= tamPilha; }
+int pilhaVazia(Pilha *p) { return p->qtd == 0; }
 
-void empilhar(Pilha *p, Peca x) { if(!pilhaCheia(p)) p->itens[++p->topo] = x; }
-Peca desempilhar(Pilha *p) { Peca r={'-',-1}; if(!pilhaVazia(p)) r=p->itens[p->topo--]; return r; }
+void empilhar(Pilha *p, Peca x) { if(!pilhaCheia(p) && Pilha_empilhar(p, x)) registrarPeca(OP_EMPILHAR, x); }
+Peca desempilhar(Pilha *p) { Peca r={'-',-1}; if(Pilha_desempilhar(p, &r)) registrarPeca(OP_DESEMPILHAR, r); return r; }
 
-void jogarPeca(Fila *f) {
-    if(filaVazia(f)) return;
+static void registrarTroca(int k) {
+    OperacaoDiario op = {0};
+    op.tipo = OP_TROCA;
+    op.u.k = k;
+    registrar(op);
+}
+
+/* Queda registrada no diario (usada pelas jogadas do jogador) */
+static int soltarRegistrada(Tabuleiro *t, char nome, int rot, int col) {
+    OperacaoDiario op = {0};
+    int y;
+    unsigned mascara;
+    int linhas = soltarPecaDetalhada(t, nome, rot, col, &y, &mascara);
+    if (linhas < 0) return linhas;
+    op.tipo = OP_SOLTAR;
+    op.u.queda.nome = nome;
+    op.u.queda.rot = (signed char)(rot & 3);
+    op.u.queda.col = (signed char)col;
+    op.u.queda.y = (signed char)y;
+    op.u.queda.removidas = (unsigned char)mascara;
+    registrar(op);
+    return linhas;
+}
+
+void jogarPeca(Fila *f, Gerador *g, Tabuleiro *t, int rot, int col) {
+    if(filaVazia(f) || t->fimDeJogo) return;
+    if(!posicaoValida(Fila_espiar(f, 0)->nome, rot, col)) { mensagem("Posicao invalida"); return; }
     Peca jogada = desenfileirar(f);
-    printf("Jogou %c[%d]\n", jogada.nome, jogada.id);
-    enfileirar(f, gerarPeca());
+    int linhas = soltarRegistrada(t, jogada.nome, rot, col);
+    mensagem("Jogou %c[%d] (%d linha(s))", jogada.nome, jogada.id, linhas);
+    enfileirar(f, gerarPecaRegistrada(g));
 }
 
-void reservarPeca(Fila *f, Pilha *p) {
+void reservarPeca(Fila *f, Pilha *p, Gerador *g) {
     if(filaVazia(f) || pilhaCheia(p)) return;
     Peca reservada = desenfileirar(f);
     empilhar(p, reservada);
-    printf("Reservou %c[%d]\n", reservada.nome, reservada.id);
-    enfileirar(f, gerarPeca());
+    mensagem("Reservou %c[%d]", reservada.nome, reservada.id);
+    enfileirar(f, gerarPecaRegistrada(g));
 }
 
-void usarReservada(Pilha *p) {
-    if(pilhaVazia(p)) return;
+void usarReservada(Pilha *p, Tabuleiro *t, int rot, int col) {
+    if(pilhaVazia(p) || t->fimDeJogo) return;
+    if(!posicaoValida(Pilha_topo(p)->nome, rot, col)) { mensagem("Posicao invalida"); return; }
     Peca usada = desempilhar(p);
-    printf("Usou %c[%d]\n", usada.nome, usada.id);
+    int linhas = soltarRegistrada(t, usada.nome, rot, col);
+    mensagem("Usou %c[%d] (%d linha(s))", usada.nome, usada.id, linhas);
 }
 
 void trocarAtual(Fila *f, Pilha *p) {
     if(filaVazia(f) || pilhaVazia(p)) return;
-    Peca aux = f->itens[f->inicio];
-    f->itens[f->inicio] = p->itens[p->topo];
-    p->itens[p->topo] = aux;
-    printf("Troca realizada\n");
+    trocarBloco(f, p, 1);
+    registrarTroca(1);
+    mensagem("Troca realizada");
 }
 
 void trocaMultipla(Fila *f, Pilha *p) {
-    if(f->qtd < 3 || p->topo < 2) return;
-    for(int i=0;i<3;i++) {
-        int pos = (f->inicio+i) % TAM_FILA;
-        Peca aux = f->itens[pos];
-        f->itens[pos] = p->itens[p->topo - i];
-        p->itens[p->topo - i] = aux;
+    if(!trocarBloco(f, p, qtdTroca)) return;
+    registrarTroca(qtdTroca);
+    mensagem("Troca multipla realizada");
+}
+
+/* ---------- Jogador automatico: busca em feixe ---------- */
+
+/* Pool de threads simples: executa tarefa(ctx, i) para i em [0, total)
+   distribuindo indices por contador atomico. A thread chamadora tambem
+   trabalha e so retorna quando todos os indices terminaram. */
+typedef struct {
+    pthread_t *threads;
+    int numThreads;
+    pthread_mutex_t mtx;
+    pthread_cond_t temTrabalho, terminou;
+    void (*tarefa)(void *ctx, int i);
+    void *ctx;
+    int total;
+    atomic_int proximo;
+    int ativos;
+    unsigned geracao;
+    int encerrar;
+} PoolThreads;
+
+static void consumirTarefas(PoolThreads *pool) {
+    int i;
+    while ((i = atomic_fetch_add(&pool->proximo, 1)) < pool->total) pool->tarefa(pool->ctx, i);
+}
+
+static void *trabalhadorPool(void *arg) {
+    PoolThreads *pool = arg;
+    unsigned vista = 0;
+    pthread_mutex_lock(&pool->mtx);
+    for (;;) {
+        while (!pool->encerrar && pool->geracao == vista) pthread_cond_wait(&pool->temTrabalho, &pool->mtx);
+        if (pool->encerrar) break;
+        vista = pool->geracao;
+        pthread_mutex_unlock(&pool->mtx);
+        consumirTarefas(pool);
+        pthread_mutex_lock(&pool->mtx);
+        if (--pool->ativos == 0) pthread_cond_signal(&pool->terminou);
+    }
+    pthread_mutex_unlock(&pool->mtx);
+    return NULL;
+}
+
+int criarPool(PoolThreads *pool, int numThreads) {
+    memset(pool, 0, sizeof(*pool));
+    pthread_mutex_init(&pool->mtx, NULL);
+    pthread_cond_init(&pool->temTrabalho, NULL);
+    pthread_cond_init(&pool->terminou, NULL);
+    if (numThreads > 1) {
+        pool->threads = malloc((size_t)(numThreads - 1) * sizeof(pthread_t));
+        if (!pool->threads) return 0;
+        for (int i = 0; i < numThreads - 1; i++) {
+            if (pthread_create(&pool->threads[i], NULL, trabalhadorPool, pool) != 0) break;
+            pool->numThreads++;
+        }
+    }
+    return 1;
+}
+
+void executarPool(PoolThreads *pool, void (*tarefa)(void *, int), void *ctx, int total) {
+    pthread_mutex_lock(&pool->mtx);
+    pool->tarefa = tarefa;
+    pool->ctx = ctx;
+    pool->total = total;
+    atomic_store(&pool->proximo, 0);
+    pool->ativos = pool->numThreads;
+    pool->geracao++;
+    pthread_cond_broadcast(&pool->temTrabalho);
+    pthread_mutex_unlock(&pool->mtx);
+
+    consumirTarefas(pool);
+
+    pthread_mutex_lock(&pool->mtx);
+    while (pool->ativos > 0) pthread_cond_wait(&pool->terminou, &pool->mtx);
+    pthread_mutex_unlock(&pool->mtx);
+}
+
+void destruirPool(PoolThreads *pool) {
+    pthread_mutex_lock(&pool->mtx);
+    pool->encerrar = 1;
+    pthread_cond_broadcast(&pool->temTrabalho);
+    pthread_mutex_unlock(&pool->mtx);
+    for (int i = 0; i < pool->numThreads; i++) pthread_join(pool->threads[i], NULL);
+    free(pool->threads);
+    pthread_mutex_destroy(&pool->mtx);
+    pthread_cond_destroy(&pool->temTrabalho);
+    pthread_cond_destroy(&pool->terminou);
+}
+
+static inline uint64_t agoraNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Jogada escolhida pela busca, aplicada sobre o estado real do jogo */
+typedef struct {
+    int trocaMultipla;  /* aplicar trocaMultipla antes */
+    int usarTroca;      /* aplicar trocarAtual antes de jogar */
+    int rot, col;
+    double valor;
+    int valida;
+    int semMemoria;     /* buffers do feixe nao puderam ser alocados */
+} Jogada;
+
+typedef struct {
+    Tabuleiro tab;
+    Jogada primeira;    /* jogada da raiz que originou este no */
+    int prox;           /* proxima peca da previa a jogar */
+    char reserva;       /* topo da pilha ('\0' se vazia) */
+    int linhas;
+    double valor;
+} NoBusca;
+
+typedef struct {
+    char *previa[2];              /* [0] fila atual, [1] apos trocaMultipla */
+    char reservaRaiz[2];
+    int tamPrevia;
+    NoBusca *feixe, *filhos;
+    int *qtdFilhos;
+    int tamFeixe;
+    int profundidade;
+    uint64_t prazo;
+    atomic_int estourou;
+    atomic_llong nos;
+} ContextoBusca;
+
+/* Heuristica do tabuleiro (pesos de Yiyuan Lee): altura agregada, buracos,
+   irregularidade e linhas removidas. Buracos saem de um AND entre a linha
+   e o OR acumulado das linhas acima. */
+double avaliarTabuleiro(const Tabuleiro *t, int linhas) {
+    int altura[LARGURA_TAB] = {0};
+    uint16_t acima = 0;
+    int buracos = 0;
+    for (int r = ALTURA_TOTAL - 1; r >= 0; r--) {
+        uint16_t novas = t->linhas[r] & (uint16_t)~acima;
+        while (novas) {
+            int c = __builtin_ctz(novas);
+            altura[c] = r + 1;
+            novas &= (uint16_t)(novas - 1);
+        }
+        buracos += __builtin_popcount(acima & (uint16_t)~t->linhas[r]);
+        acima |= t->linhas[r];
+    }
+    int soma = 0, irregular = 0;
+    for (int c = 0; c < LARGURA_TAB; c++) {
+        soma += altura[c];
+        if (c > 0) irregular += abs(altura[c] - altura[c - 1]);
+    }
+    return -0.510066 * soma + 0.760666 * linhas - 0.35663 * buracos - 0.184483 * irregular;
+}
+
+static int rotacoesDistintas(char nome) {
+    switch (nome) {
+        case 'O': return 1;
+        case 'I': case 'S': case 'Z': return 2;
+        default: return 4;
+    }
+}
+
+/* Expande um no do feixe: joga a proxima peca da previa ou (via
+   trocarAtual) a reserva, em todas as rotacoes/colunas validas. */
+static void expandirNo(void *arg, int i) {
+    ContextoBusca *ctx = arg;
+    const NoBusca *no = &ctx->feixe[i];
+    NoBusca *saida = &ctx->filhos[(size_t)i * MAX_FILHOS];
+    int n = 0;
+    /* a primeira camada sempre termina: ha jogada mesmo com prazo vencido */
+    if (ctx->profundidade > 0 &&
+        (atomic_load_explicit(&ctx->estourou, memory_order_relaxed) || agoraNs() > ctx->prazo)) {
+        atomic_store(&ctx->estourou, 1);
+        ctx->qtdFilhos[i] = 0;
+        return;
+    }
+    const char *previa = ctx->previa[no->primeira.trocaMultipla];
+    char daFila = previa[no->prox];
+    for (int troca = 0; troca < 2; troca++) {
+        char jogar = troca ? no->reserva : daFila;
+        char novaReserva = troca ? daFila : no->reserva;
+        if (!jogar || (troca && jogar == daFila)) continue;
+        for (int rot = 0; rot < rotacoesDistintas(jogar); rot++) {
+            int larg = larguraForma(formaPeca(jogar, rot));
+            for (int col = 0; col + larg <= LARGURA_TAB; col++) {
+                NoBusca *filho = &saida[n];
+                filho->tab = no->tab;
+                int linhas = soltarPeca(&filho->tab, jogar, rot, col);
+                if (linhas < 0 || filho->tab.fimDeJogo) continue;
+                filho->primeira = no->primeira;
+                if (ctx->profundidade == 0) {
+                    filho->primeira.usarTroca = troca;
+                    filho->primeira.rot = rot;
+                    filho->primeira.col = col;
+                }
+                filho->prox = no->prox + 1;
+                filho->reserva = novaReserva;
+                filho->linhas = no->linhas + linhas;
+                filho->valor = avaliarTabuleiro(&filho->tab, filho->linhas);
+                n++;
+            }
+        }
+    }
+    ctx->qtdFilhos[i] = n;
+    atomic_fetch_add_explicit(&ctx->nos, n, memory_order_relaxed);
+}
+
+static int compararNos(const void *a, const void *b) {
+    double va = ((const NoBusca *)a)->valor, vb = ((const NoBusca *)b)->valor;
+    return (va < vb) - (va > vb);
+}
+
+/* Busca em feixe sobre a previa da fila (e trocas com a pilha) com
+   orcamento de tempo por jogada (orcamentoMs <= 0: so a primeira camada).
+   Retorna a melhor jogada da raiz. */
+Jogada buscarJogada(Fila *f, Pilha *p, Tabuleiro *t, PoolThreads *pool,
+                    int larguraFeixe, int orcamentoMs, long long *nosAvaliados) {
+    INSTR_ESCOPO(buscarJogada);
+    Jogada melhor = {0};
+    ContextoBusca ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.tamPrevia = f->qtd;
+    if (ctx.tamPrevia == 0 || t->fimDeJogo) return melhor;
+    ctx.previa[0] = malloc(2 * (size_t)ctx.tamPrevia);
+    if (!ctx.previa[0]) return melhor;
+    ctx.previa[1] = ctx.previa[0] + ctx.tamPrevia;
+    for (int i = 0; i < f->qtd; i++) ctx.previa[0][i] = ctx.previa[1][i] = Fila_espiar(f, i)->nome;
+    ctx.reservaRaiz[0] = ctx.reservaRaiz[1] = pilhaVazia(p) ? '\0' : Pilha_topo(p)->nome;
+    int podeMultipla = qtdTroca > 0 && f->qtd >= qtdTroca && p->qtd >= qtdTroca;
+    if (podeMultipla) {
+        for (int i = 0; i < qtdTroca; i++) ctx.previa[1][i] = Pilha_espiar(p, i)->nome;
+        ctx.reservaRaiz[1] = ctx.previa[0][0];
+    }
+
+    /* o feixe guarda no maximo larguraFeixe nos (2 raizes na 1a camada);
+       cada no gera ate MAX_FILHOS filhos */
+    size_t maxFeixe = larguraFeixe > 2 ? (size_t)larguraFeixe : 2;
+    ctx.feixe = malloc(maxFeixe * sizeof(NoBusca));
+    ctx.filhos = malloc(maxFeixe * MAX_FILHOS * sizeof(NoBusca));
+    ctx.qtdFilhos = malloc(maxFeixe * sizeof(int));
+    if (!ctx.feixe || !ctx.filhos || !ctx.qtdFilhos) { melhor.semMemoria = 1; goto fim; }
+
+    ctx.prazo = agoraNs() + (uint64_t)(orcamentoMs > 0 ? orcamentoMs : 0) * 1000000ull;
+    for (int v = 0; v <= podeMultipla; v++) {
+        NoBusca *raiz = &ctx.feixe[ctx.tamFeixe++];
+        memset(raiz, 0, sizeof(*raiz));
+        raiz->tab = *t;
+        raiz->primeira.trocaMultipla = v;
+        raiz->reserva = ctx.reservaRaiz[v];
+    }
+
+    for (ctx.profundidade = 0; ctx.profundidade < ctx.tamPrevia; ctx.profundidade++) {
+        executarPool(pool, expandirNo, &ctx, ctx.tamFeixe);
+        if (atomic_load(&ctx.estourou)) break;
+        int total = 0;
+        for (int i = 0; i < ctx.tamFeixe; i++) {
+            NoBusca *origem = &ctx.filhos[(size_t)i * MAX_FILHOS];
+            memmove(&ctx.filhos[total], origem, (size_t)ctx.qtdFilhos[i] * sizeof(NoBusca));
+            total += ctx.qtdFilhos[i];
+        }
+        if (total == 0) break;
+        qsort(ctx.filhos, (size_t)total, sizeof(NoBusca), compararNos);
+        ctx.tamFeixe = total < larguraFeixe ? total : larguraFeixe;
+        memcpy(ctx.feixe, ctx.filhos, (size_t)ctx.tamFeixe * sizeof(NoBusca));
+        melhor = ctx.feixe[0].primeira;
+        melhor.valor = ctx.feixe[0].valor;
+        melhor.valida = 1;
+        if (atomic_load(&ctx.estourou)) break;
+    }
+
+fim:
+    if (nosAvaliados) *nosAvaliados += atomic_load(&ctx.nos);
+    free(ctx.feixe);
+    free(ctx.filhos);
+    free(ctx.qtdFilhos);
+    free(ctx.previa[0]);
+    return melhor;
+}
+
+/* Monta o quadro (tabuleiro, fila, pilha, status e menu) e apresenta so
+   o que mudou desde o quadro anterior */
+void exibirEstado(Tela *tela, Fila *f, Pilha *p, Tabuleiro *t) {
+    char linha[LARGURA_TAB + 3];
+    char lista[TELA_LARGURA];
+    int x = LARGURA_TAB + 4, n = 0;
+    telaLimpar(tela);
+    linha[0] = '|'; linha[LARGURA_TAB + 1] = '|'; linha[LARGURA_TAB + 2] = '\0';
+    for(int r=ALTURA_TAB-1;r>=0;r--) {
+        for(int c=0;c<LARGURA_TAB;c++) linha[c + 1] = (t->linhas[r] >> c & 1) ? '#' : '.';
+        telaEscrever(tela, 0, ALTURA_TAB-1-r, "%s", linha);
+    }
+    memset(linha + 1, '-', LARGURA_TAB); linha[0] = linha[LARGURA_TAB + 1] = '+';
+    telaEscrever(tela, 0, ALTURA_TAB, "%s", linha);
+    telaEscrever(tela, x, 0, "Linhas: %d", t->linhasLimpas);
+
+    lista[0] = '\0';
+    for(int i=0;i<f->qtd && n < (int)sizeof(lista);i++) {
+        Peca *pc = Fila_espiar(f, i);
+        n += snprintf(lista + n, sizeof(lista) - n, "%c[%d] ", pc->nome, pc->id);
+    }
+    telaEscrever(tela, x, 2, "Fila: %s", lista);
+    lista[0] = '\0'; n = 0;
+    for(int i=p->qtd-1;i>=0 && n < (int)sizeof(lista);i--) {
+        Peca *pc = Pilha_espiar(p, i);
+        n += snprintf(lista + n, sizeof(lista) - n, "%c[%d] ", pc->nome, pc->id);
+    }
+    telaEscrever(tela, x, 4, "Pilha: %s", lista);
+
+    telaEscrever(tela, x, 7, "1-Jogar 2-Reservar 3-Usar 4-Trocar 5-Troca multipla");
+    telaEscrever(tela, x, 8, "6-Auto 7-Desfazer 8-Refazer 0-Sair");
+    telaEscrever(tela, 0, ALTURA_TAB + 1, "%s", ultimaMensagem);
+    telaApresentar(tela);
+}
+
+/* Aplica a jogada escolhida pela busca usando as operacoes normais do jogo.
+   Retorna 1 se jogou, 0 se nao ha jogada e -1 se faltou memoria. */
+int jogadaAutomatica(Fila *f, Pilha *p, Gerador *g, Tabuleiro *t, PoolThreads *pool,
+                     int larguraFeixe, int orcamentoMs, long long *nosAvaliados) {
+    Jogada j = buscarJogada(f, p, t, pool, larguraFeixe, orcamentoMs, nosAvaliados);
+    if (j.semMemoria) return -1;
+    if (!j.valida) return 0;
+    iniciarAcao();
+    if (j.trocaMultipla) trocaMultipla(f, p);
+    if (j.usarTroca) trocarAtual(f, p);
+    jogarPeca(f, g, t, j.rot, j.col);
+    return 1;
+}
+
+/* ---------- Modo sem interface ---------- */
+
+/* FNV-1a 64 bits sobre fila, pilha, tabuleiro e contadores */
+static uint64_t misturar(uint64_t h, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        h ^= (v >> (8 * i)) & 0xFF;
+        h *= 0x100000001B3ULL;
     }
-    printf("Troca múltipla realizada\n");
+    return h;
 }
 
-void exibirEstado(Fila *f, Pilha *p) {
-    printf("\nFila: ");
-    for(int i=0;i<f->qtd;i++) {
-        int pos = (f->inicio+i) % TAM_FILA;
-        printf("%c[%d] ", f->itens[pos].nome, f->itens[pos].id);
+uint64_t checksumEstado(Fila *f, Pilha *p, Tabuleiro *t) {
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (int i = 0; i < f->qtd; i++) {
+        Peca x = *Fila_espiar(f, i);
+        h = misturar(h, (uint64_t)(unsigned char)x.nome << 32 | (uint32_t)x.id);
+    }
+    h = misturar(h, (uint64_t)f->qtd);
+    for (int i = p->qtd - 1; i >= 0; i--) {
+        Peca x = *Pilha_espiar(p, i);
+        h = misturar(h, (uint64_t)(unsigned char)x.nome << 32 | (uint32_t)x.id);
+    }
+    h = misturar(h, (uint64_t)p->qtd);
+    for (int r = 0; r < ALTURA_TOTAL; r++) h = misturar(h, t->linhas[r]);
+    return misturar(h, (uint64_t)t->linhasLimpas);
+}
+
+/* Rotacao e coluna validas para a peca, sorteadas do PRNG de posicoes */
+static void sortearPosicao(char nome, uint64_t *s, int *rot, int *col) {
+    uint64_t r = proximoAleatorio(s);
+    *rot = (int)(r & 3);
+    int livres = LARGURA_TAB - larguraForma(formaPeca(nome, *rot)) + 1;
+    *col = (int)(((r >> 32) * (uint64_t)livres) >> 32);
+}
+
+/* Roda a sequencia de acoes sem saida. As posicoes das jogadas (1 e 3)
+   vem de um PRNG derivado da semente, entao replay + semente reproduz o
+   mesmo estado. Ao perder, o tabuleiro e reiniciado e o jogo continua. */
+int executarHeadless(uint64_t semente, long long numAcoes, const char *arqReplay, const char *arqGravar,
+                     int comDiario, int capHistorico) {
+    int maxAcao = comDiario ? 7 : 5;
+    unsigned char *acoes = NULL;
+    long long n = 0;
+    uint64_t sorteio = semente ^ 0xA5A5A5A5DEADBEEFULL;
+    if (!sorteio) sorteio = 1;
+
+    if (arqReplay) {
+        FILE *in = fopen(arqReplay, "r");
+        if (!in) { fprintf(stderr, "Nao foi possivel abrir %s\n", arqReplay); return 1; }
+        long long cap = 1 << 16;
+        int a;
+        acoes = malloc((size_t)cap);
+        while (acoes && fscanf(in, "%d", &a) == 1) {
+            if (a < 1 || a > maxAcao) continue;
+            if (n == cap) {
+                unsigned char *maior = realloc(acoes, (size_t)(cap *= 2));
+                if (!maior) { free(acoes); acoes = NULL; break; }
+                acoes = maior;
+            }
+            acoes[n++] = (unsigned char)a;
+        }
+        fclose(in);
+    } else {
+        n = numAcoes;
+        acoes = malloc((size_t)(n > 0 ? n : 1));
+        for (long long i = 0; acoes && i < n; i++)
+            acoes[i] = (unsigned char)(1 + ((proximoAleatorio(&sorteio) >> 32) * (uint64_t)maxAcao >> 32));
+    }
+    if (!acoes) { fprintf(stderr, "Erro de alocacao das acoes\n"); return 1; }
+
+    if (arqGravar) {
+        FILE *out = fopen(arqGravar, "w");
+        if (!out) { fprintf(stderr, "Nao foi possivel criar %s\n", arqGravar); free(acoes); return 1; }
+        for (long long i = 0; i < n; i++) fprintf(out, "%d\n", acoes[i]);
+        fclose(out);
+    }
+
+    Fila f; Pilha p; Gerador g; Tabuleiro t;
+    inicializarFila(&f); inicializarPilha(&p);
+    inicializarGerador(&g, semente);
+    inicializarTabuleiro(&t);
+    for (int i = 0; i < tamFila; i++) enfileirar(&f, gerarPeca(&g));
+    Diario d;
+    if (comDiario) {
+        if (!criarDiario(&d, capHistorico)) { fprintf(stderr, "Erro de alocacao do diario\n"); free(acoes); return 1; }
+        diarioAtivo = &d;
+    }
+
+    uint64_t posicoes = semente ^ 0x5DEECE66DULL;
+    if (!posicoes) posicoes = 1;
+    long long porAcao[8] = {0};
+    long long reinicios = 0, linhasTotais = 0, conferidas = 0, divergencias = 0;
+    int rot = 0, col = 0;
+    silencioso = 1;
+    uint64_t inicio = agoraNs();
+    for (long long i = 0; i < n; i++) {
+        uint64_t antes = 0, cursorAntes = 0;
+        if (comDiario) {
+            antes = checksumEstado(&f, &p, &t);
+            cursorAntes = d.cursor;
+        }
+        iniciarAcao();
+        switch (acoes[i]) {
+            case 1:
+                if (!filaVazia(&f)) sortearPosicao(Fila_espiar(&f, 0)->nome, &posicoes, &rot, &col);
+                jogarPeca(&f, &g, &t, rot, col);
+                break;
+            case 2: reservarPeca(&f, &p, &g); break;
+            case 3:
+                if (!pilhaVazia(&p)) sortearPosicao(Pilha_topo(&p)->nome, &posicoes, &rot, &col);
+                usarReservada(&p, &t, rot, col);
+                break;
+            case 4: trocarAtual(&f, &p); break;
+            case 5: trocaMultipla(&f, &p); break;
+            case 6: desfazer(&d, &f, &p, &t, &g); break;
+            case 7: refazer(&d, &f, &p, &t, &g); break;
+        }
+        porAcao[acoes[i]]++;
+        /* confere a acao isolada antes que um reinicio limpe o diario:
+           o passo inverso volta ao checksum de antes, o direto ao de depois */
+        if (comDiario && d.cursor != cursorAntes) {
+            uint64_t depois = checksumEstado(&f, &p, &t);
+            int recuou = d.cursor < cursorAntes;
+            if (recuou) refazer(&d, &f, &p, &t, &g); else desfazer(&d, &f, &p, &t, &g);
+            divergencias += checksumEstado(&f, &p, &t) != antes;
+            if (recuou) desfazer(&d, &f, &p, &t, &g); else refazer(&d, &f, &p, &t, &g);
+            divergencias += checksumEstado(&f, &p, &t) != depois;
+            conferidas++;
+        }
+        if (t.fimDeJogo) {
+            linhasTotais += t.linhasLimpas;
+            inicializarTabuleiro(&t);
+            reinicios++;
+            if (comDiario) limparDiario(&d);   /* reinicio nao e reversivel */
+        }
+    }
+    uint64_t decorrido = agoraNs() - inicio;
+    silencioso = 0;
+    linhasTotais += t.linhasLimpas;
+
+    double seg = decorrido / 1e9;
+    printf("Acoes: %lld (1:%lld 2:%lld 3:%lld 4:%lld 5:%lld 6:%lld 7:%lld)\n", n,
+           porAcao[1], porAcao[2], porAcao[3], porAcao[4], porAcao[5], porAcao[6], porAcao[7]);
+    printf("Pecas geradas: %d  Linhas: %lld  Reinicios: %lld\n", g.contadorId - 1, linhasTotais, reinicios);
+    printf("Checksum: %016llx\n", (unsigned long long)checksumEstado(&f, &p, &t));
+    printf("Tempo: %.3f ms (%.2f Mops/s, %.1f ns/op)\n", seg * 1e3,
+           seg > 0 ? n / seg / 1e6 : 0.0, n > 0 ? (double)decorrido / n : 0.0);
+    int falhou = 0;
+    if (comDiario) {
+        printf("Diario: %lld acoes desfeitas e refeitas uma a uma, %lld divergencias\n",
+               conferidas, divergencias);
+        /* desfaz todo o historico retido e refaz ate o mesmo ponto */
+        uint64_t esperado = checksumEstado(&f, &p, &t);
+        long long desfeitas = 0;
+        while (desfazer(&d, &f, &p, &t, &g)) desfeitas++;
+        for (long long i = 0; i < desfeitas; i++) refazer(&d, &f, &p, &t, &g);
+        int confere = checksumEstado(&f, &p, &t) == esperado;
+        printf("Historico final: %lld acoes desfeitas e refeitas, checksum %s\n", desfeitas,
+               confere ? "confere" : "DIVERGE");
+        falhou = divergencias > 0 || !confere;
+        diarioAtivo = NULL;
+        liberarDiario(&d);
     }
-    printf("\nPilha: ");
-    for(int i=0;i<=p->topo;i++) {
-        printf("%c[%d] ", p->itens[i].nome, p->itens[i].id);
+    free(acoes);
+    Fila_liberar(&f);
+    Pilha_liberar(&p);
+    return falhou;
+}
+
+/* ---------- Benchmark das estruturas ---------- */
+
+#define BENCH_OPS 20000000LL
+
+static volatile long long sumidouro;
+
+/* Referencias item a item com modulo, como a fila/troca originais */
+static void trocaIngenua(Peca *fila, int cap, int inicio, Peca *pilha, int topo, int k) {
+    for (int i = 0; i < k; i++) {
+        int pos = (inicio + i) % cap;
+        Peca aux = fila[pos];
+        fila[pos] = pilha[topo - i];
+        pilha[topo - i] = aux;
     }
-    printf("\n\n");
 }
 
-int main() {
-    Fila fila; Pilha pilha;
+static void copiaIngenua(const Peca *fila, int cap, int inicio, int n, Peca *destino) {
+    for (int i = 0; i < n; i++) destino[i] = fila[(inicio + i) % cap];
+}
+
+/* Mede ciclo inserir/remover, troca em bloco de cap/2 itens e copia de
+   faixa de cap/2 itens (comparando com as versoes item a item). O ciclo
+   gira o inicio do anel, entao trocas e copias atravessam a volta. */
+#define BENCH_ESTRUTURA(nomeFuncao, Deque, Pilha, troca)                        \
+static void nomeFuncao(const char *sabor, int cap) {                            \
+    static Deque d;                                                             \
+    static Pilha p;                                                             \
+    Deque##_iniciar(&d);                                                        \
+    Pilha##_iniciar(&p);                                                        \
+    Peca x = {'I', 0}, *buf = calloc((size_t)cap, sizeof(Peca));                \
+    if (!buf || !Deque##_garantir(&d, cap) || !Pilha##_garantir(&p, cap)) {     \
+        free(buf);                                                              \
+        return;                                                                 \
+    }                                                                           \
+    long long soma = 0;                                                         \
+    int k = cap / 2;                                                            \
+    for (int i = 0; i < k; i++) {                                               \
+        x.id = i;                                                               \
+        Deque##_inserirFim(&d, x);                                              \
+        Pilha##_empilhar(&p, x);                                                \
+    }                                                                           \
+    uint64_t t0 = agoraNs();                                                    \
+    for (long long i = 0; i < BENCH_OPS; i++) {                                 \
+        Deque##_inserirFim(&d, x);                                              \
+        Deque##_removerInicio(&d, &x);                                          \
+        soma += x.id;                                                           \
+    }                                                                           \
+    double nsCiclo = (double)(agoraNs() - t0) / BENCH_OPS;                      \
+    long long rep = BENCH_OPS / k;                                              \
+    t0 = agoraNs();                                                             \
+    for (long long r = 0; r < rep; r++) troca(&d, &p, k);                       \
+    double nsTroca = (double)(agoraNs() - t0) / (rep * k);                      \
+    t0 = agoraNs();                                                             \
+    for (long long r = 0; r < rep; r++)                                         \
+        trocaIngenua(Deque##_dados(&d), Deque##_capacidade(&d), d.inicio,       \
+                     Pilha##_dados(&p), p.qtd - 1, k);                          \
+    double nsTrocaIng = (double)(agoraNs() - t0) / (rep * k);                   \
+    t0 = agoraNs();                                                             \
+    for (long long r = 0; r < rep; r++) {                                       \
+        soma += Deque##_copiarFaixa(&d, 0, k, buf);                             \
+        soma += buf[r % k].id;                                                  \
+    }                                                                           \
+    double nsCopia = (double)(agoraNs() - t0) / (rep * k);                      \
+    t0 = agoraNs();                                                             \
+    for (long long r = 0; r < rep; r++) {                                       \
+        copiaIngenua(Deque##_dados(&d), Deque##_capacidade(&d), d.inicio, k, buf); \
+        soma += buf[r % k].id;                                                  \
+    }                                                                           \
+    double nsCopiaIng = (double)(agoraNs() - t0) / (rep * k);                   \
+    printf("%7d  %-9s %8.2f %10.3f %10.3f %10.3f %10.3f\n", cap, sabor,        \
+           nsCiclo, nsTroca, nsTrocaIng, nsCopia, nsCopiaIng);                  \
+    sumidouro += soma;                                                          \
+    free(buf);                                                                  \
+    Deque##_liberar(&d);                                                        \
+    Pilha##_liberar(&p);                                                        \
+}
+
+#define BENCH_FIXO(CAP)                                                         \
+    DEFINIR_DEQUE_FIXO(DequeF##CAP, Peca, CAP)                                  \
+    DEFINIR_PILHA_FIXA(PilhaF##CAP, Peca, CAP)                                  \
+    DEFINIR_TROCA_DEQUE_PILHA(trocarF##CAP, DequeF##CAP, PilhaF##CAP, Peca)     \
+    BENCH_ESTRUTURA(benchFixo##CAP, DequeF##CAP, PilhaF##CAP, trocarF##CAP)
+
+BENCH_FIXO(8)
+BENCH_FIXO(64)
+BENCH_FIXO(1024)
+BENCH_FIXO(16384)
+BENCH_ESTRUTURA(benchDinamico, Fila, Pilha, trocarBloco)
+
+int benchEstruturas(void) {
+    printf("    cap  sabor     ciclo ns  troca ns/i  ingenua    copia ns/i  ingenua\n");
+    benchFixo8("fixo", 8);          benchDinamico("dinamico", 8);
+    benchFixo64("fixo", 64);        benchDinamico("dinamico", 64);
+    benchFixo1024("fixo", 1024);    benchDinamico("dinamico", 1024);
+    benchFixo16384("fixo", 16384);  benchDinamico("dinamico", 16384);
+
+    /* crescimento amortizado: insere BENCH_OPS itens partindo do vazio */
+    Fila f;
+    Fila_iniciar(&f);
+    Peca x = {'I', 0};
+    uint64_t t0 = agoraNs();
+    for (long long i = 0; i < BENCH_OPS; i++) { x.id = (int)i; Fila_inserirFim(&f, x); }
+    printf("Crescimento dinamico: %.2f ns/insercao (capacidade final %d)\n",
+           (double)(agoraNs() - t0) / BENCH_OPS, f.cap);
+    Fila_liberar(&f);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    INSTR_INICIAR();
+    Fila fila; Pilha pilha; Gerador gerador; Tabuleiro tab; PoolThreads pool; Tela tela; Diario diario;
+    uint64_t semente = (uint64_t)time(NULL);
+    int larguraFeixe = FEIXE_PADRAO, orcamentoMs = ORCAMENTO_PADRAO_MS;
+    int numThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int headless = 0, conferir = 0, renderCompleto = 0, comDiario = 0, capHistorico = HISTORICO_PADRAO;
+    long long numAcoes = 1000000;
+    const char *arqReplay = NULL, *arqGravar = NULL;
+    for(int i=1;i<argc;i++) {
+        if(strcmp(argv[i],"--headless")==0) headless = 1;
+        else if(strcmp(argv[i],"--render-completo")==0) renderCompleto = 1;
+        else if(strcmp(argv[i],"--desfazer")==0) comDiario = 1;
+        else if(strcmp(argv[i],"--historico")==0 && i+1<argc) capHistorico = atoi(argv[++i]);
+        else if(strcmp(argv[i],"--acoes")==0 && i+1<argc) numAcoes = atoll(argv[++i]);
+        else if(strcmp(argv[i],"--replay")==0 && i+1<argc) arqReplay = argv[++i];
+        else if(strcmp(argv[i],"--gravar")==0 && i+1<argc) arqGravar = argv[++i];
+        else if(strcmp(argv[i],"--bench-estruturas")==0) return benchEstruturas();
+        else if(strcmp(argv[i],"--conferir-gerador")==0) conferir = 1;
+        else if(strcmp(argv[i],"--fila")==0 && i+1<argc) tamFila = atoi(argv[++i]);
+        else if(strcmp(argv[i],"--pilha")==0 && i+1<argc) tamPilha = atoi(argv[++i]);
+        else if(strcmp(argv[i],"--troca")==0 && i+1<argc) qtdTroca = atoi(argv[++i]);
+        else if(strcmp(argv[i],"--feixe")==0 && i+1<argc) larguraFeixe = atoi(argv[++i]);
+        else if(strcmp(argv[i],"--orcamento-ms")==0 && i+1<argc) orcamentoMs = atoi(argv[++i]);
+        else if(strcmp(argv[i],"--threads")==0 && i+1<argc) numThreads = atoi(argv[++i]);
+        else semente = strtoull(argv[i], NULL, 10);
+    }
+    if(tamFila < 1) tamFila = 1;
+    if(tamPilha < 0) tamPilha = 0;
+    if(conferir) return conferirGerador(semente, 100000, 100000000);
+    if(headless) return executarHeadless(semente, numAcoes, arqReplay, arqGravar, comDiario, capHistorico);
+    if(larguraFeixe < 1) larguraFeixe = 1;
+    if(orcamentoMs < 0) orcamentoMs = 0;
+    if(numThreads < 1) numThreads = 1;
+    if(!criarPool(&pool, numThreads)) { fprintf(stderr, "Erro ao criar threads\n"); return 1; }
+    if(!telaIniciar(&tela, TELA_LARGURA, TELA_ALTURA, !renderCompleto)) { fprintf(stderr, "Erro de alocacao da tela\n"); return 1; }
     inicializarFila(&fila); inicializarPilha(&pilha);
-    srand(time(NULL));
-    for(int i=0;i<TAM_FILA;i++) enfileirar(&fila, gerarPeca());
+    inicializarGerador(&gerador, semente);
+    inicializarTabuleiro(&tab);
+    for(int i=0;i<tamFila;i++) enfileirar(&fila, gerarPeca(&gerador));
+    if(!criarDiario(&diario, capHistorico)) { fprintf(stderr, "Erro de alocacao do diario\n"); return 1; }
+    diarioAtivo = &diario;
 
-    int opcao;
+    int opcao, rot, col;
     do {
-        exibirEstado(&fila,&pilha);
-        printf("1-Jogar  2-Reservar  3-Usar reservada  4-Trocar atual  5-Troca múltipla  0-Sair\n");
-        scanf("%d",&opcao);
+        /* Fim de jogo nao encerra: o quadro fica na tela e 7-Desfazer volta ao jogo */
+        if(tab.fimDeJogo) mensagem("Fim de jogo! Linhas: %d (7-Desfazer, 0-Sair)", tab.linhasLimpas);
+        exibirEstado(&tela,&fila,&pilha,&tab);
+        telaPrompt(&tela, "> ");
+        if(scanf("%d",&opcao) != 1) break;
+        if(tab.fimDeJogo && opcao >= 1 && opcao <= 6) continue;
+        if(opcao == 1 || opcao == 3) {
+            telaPrompt(&tela, "Rotacao (0-3) e coluna (0-%d): ", LARGURA_TAB-1);
+            if(scanf("%d %d",&rot,&col) != 2) { rot = 0; col = 0; }
+        }
+        iniciarAcao();
         switch(opcao) {
-            case 1: jogarPeca(&fila); break;
-            case 2: reservarPeca(&fila,&pilha); break;
-            case 3: usarReservada(&pilha); break;
+            case 1: jogarPeca(&fila,&gerador,&tab,rot,col); break;
+            case 2: reservarPeca(&fila,&pilha,&gerador); break;
+            case 3: usarReservada(&pilha,&tab,rot,col); break;
             case 4: trocarAtual(&fila,&pilha); break;
             case 5: trocaMultipla(&fila,&pilha); break;
+            case 6: {
+                int qtd = 1;
+                telaPrompt(&tela, "Quantas pecas: ");
+                if(scanf("%d",&qtd) != 1 || qtd < 1) qtd = 1;
+                long long nos = 0;
+                int jogadas = 0, r = 1;
+                silencioso = qtd > 1;
+                uint64_t inicio = agoraNs();
+                while(jogadas < qtd && (r = jogadaAutomatica(&fila,&pilha,&gerador,&tab,&pool,larguraFeixe,orcamentoMs,&nos)) > 0) jogadas++;
+                double seg = (agoraNs() - inicio) / 1e9;
+                silencioso = 0;
+                if(r < 0) mensagem("Sem memoria para o feixe de %d nos (reduza --feixe)", larguraFeixe);
+                else mensagem("Pecas %d em %.3f s (%.1f/s), nos %lld (%.0f/s)",
+                         jogadas, seg, seg > 0 ? jogadas / seg : 0.0, nos, seg > 0 ? nos / seg : 0.0);
+                break;
+            }
+            case 7: mensagem(desfazer(&diario,&fila,&pilha,&tab,&gerador) ? "Acao desfeita" : "Nada para desfazer"); break;
+            case 8: mensagem(refazer(&diario,&fila,&pilha,&tab,&gerador) ? "Acao refeita" : "Nada para refazer"); break;
         }
     } while(opcao!=0);
 
+    telaEstatisticas(&tela, stderr);
+    telaLiberar(&tela);
+    destruirPool(&pool);
+    diarioAtivo = NULL;
+    liberarDiario(&diario);
+    Fila_liberar(&fila);
+    Pilha_liberar(&pilha);
     return 0;
 }
\ No newline at end of file